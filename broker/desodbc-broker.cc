@@ -0,0 +1,709 @@
+// Copyright (c) 2025 Sergio Miguel Garcia Jimenez <segarc21@ucm.es>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0, as
+// published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+// ---------------------------------------------------------
+// This file is part of DESODBC, an ODBC Driver of the open-source DBMS
+// Datalog Educational System (DES) (see https://des.sourceforge.io/),
+// written by Sergio Miguel Garcia Jimenez <segarc21@ucm.es>, hereinafter
+// the DESODBC developer.
+// ---------------------------------------------------------
+
+/**
+  @file  desodbc-broker.cc
+  @brief DES broker: a process that owns the standard input and output of
+         the DES process and lets many client processes share it through a
+         Unix domain socket (DES_BROKER option). It is launched by the
+         driver (see DBC::launch_DES_broker in driver/broker.cc).
+*/
+
+#include "driver.h"
+
+#include <sys/file.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <map>
+
+/* DESODBC:
+  Lines that the broker writes into DES so as to know where the output of
+  a turn (or of its own start-up commands) ends.
+
+  Original author: DESODBC Developer
+*/
+#define BROKER_FENCE_BASE "DESODBC_BROKER_FENCE_"
+
+/* DESODBC:
+  Milliseconds that DES has to quit once the broker has no clients left,
+  before it is killed.
+
+  Original author: DESODBC Developer
+*/
+#define BROKER_QUIT_TIMEOUT_MS 5000
+
+namespace {
+
+/* DESODBC:
+  This function waits up to timeout_ms milliseconds for fd to be readable,
+  returning what poll returns.
+
+  Original author: DESODBC Developer
+*/
+int wait_for_input(int fd, int timeout_ms) {
+  struct pollfd pfd = {fd, POLLIN, 0};
+  int ret;
+  while ((ret = poll(&pfd, 1, timeout_ms)) == -1 && errno == EINTR);
+  return ret;
+}
+
+/* DESODBC:
+  What the broker needs to know, given in its command line by the
+  connection that launches it (see main).
+
+  Original author: DESODBC Developer
+*/
+struct BrokerConfig {
+  std::string des_exec_path;
+  std::string des_working_dir;
+  std::string socket_name;
+  std::string lock_name;
+  std::string snapshot_path;
+  int linger = 0;
+};
+
+/* DESODBC:
+  A connection to the broker. Its lines are handed to DES in the order
+  they arrive, and DES output is queued in out until the socket takes it.
+
+  Original author: DESODBC Developer
+*/
+struct BrokerClient {
+  std::string in;
+  std::string out;
+  std::string lock_reply;  // markers sent back once the lock is granted
+};
+
+/* DESODBC:
+  The broker. DES runs one turn at a time: some complete lines of a single
+  client, followed by a fence, whose output is sent back to that client.
+  Turns go round-robin over the clients with lines waiting. While a client
+  holds the lock (its query mutex), only its lines get turns; the lock is
+  granted in FIFO order and is released when its holder disconnects, so a
+  crashed client cannot keep the others waiting.
+
+  Original author: DESODBC Developer
+*/
+class DESBroker {
+ public:
+  explicit DESBroker(const BrokerConfig &config) : config(config) {}
+
+  char start();
+  void run();
+
+ private:
+  BrokerConfig config;
+
+  int listen_fd = -1;
+  int des_in = -1;
+  int des_out = -1;
+  pid_t des_pid = -1;
+
+  std::map<int, BrokerClient> clients;
+  std::deque<int> lock_queue;  // its first client holds the lock
+  int last_turn_fd = -1;
+
+  bool turn_pending = false;
+  int turn_fd = -1;  // -1 once the client of the turn has disconnected
+  std::string fence = "";
+  unsigned long long fence_seq = 0;
+  std::string des_buffer = "";
+
+  std::string next_fence();
+  bool write_des(const std::string &data);
+  bool read_des_until(const std::string &marker, std::string *output,
+                      int timeout_ms);
+  void accept_clients();
+  void read_client(int fd);
+  void handle_requests(int fd);
+  void handle_request(int fd, const std::string &line);
+  void grant_lock();
+  void drop_client(int fd);
+  void write_client(int fd);
+  void schedule();
+  bool read_des();
+  bool try_shutdown();
+  void quit_des();
+};
+
+/* DESODBC:
+  Original author: DESODBC Developer
+*/
+bool is_des_line(const std::string &line) {
+  return line.compare(0, 6, "/tapi ") == 0;
+}
+
+/* DESODBC:
+  Original author: DESODBC Developer
+*/
+bool ends_with_marker(std::string_view line, const std::string &marker,
+                      size_t &marker_pos) {
+  if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+  if (line.size() < marker.size()) return false;
+  marker_pos = line.size() - marker.size();
+  return line.compare(marker_pos, marker.size(), marker) == 0;
+}
+
+std::string DESBroker::next_fence() {
+  return BROKER_FENCE_BASE + std::to_string(++this->fence_seq);
+}
+
+/* DESODBC:
+  The DES input pipe is blocking. We only write into it when DES has
+  consumed everything written before (see schedule), so it never has to
+  wait for us to read its output.
+
+  Original author: DESODBC Developer
+*/
+bool DESBroker::write_des(const std::string &data) {
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t n =
+        write(this->des_in, data.c_str() + written, data.size() - written);
+    if (n >= 0)
+      written += n;
+    else if (errno != EINTR)
+      return false;
+  }
+  return true;
+}
+
+/* DESODBC:
+  This function reads DES output until a line that ends with marker,
+  appending the lines before it to output (if any). It is only used while
+  the broker is starting up.
+
+  Original author: DESODBC Developer
+*/
+bool DESBroker::read_des_until(const std::string &marker, std::string *output,
+                               int timeout_ms) {
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(timeout_ms);
+  char buffer[BUFFER_SIZE];
+
+  while (true) {
+    size_t nl;
+    while ((nl = this->des_buffer.find('\n')) != std::string::npos) {
+      std::string_view line(this->des_buffer.data(), nl);
+      size_t marker_pos = 0;
+      bool found = ends_with_marker(line, marker, marker_pos);
+      if (output) output->append(this->des_buffer, 0, found ? marker_pos : nl + 1);
+      this->des_buffer.erase(0, nl + 1);
+      if (found) return true;
+    }
+
+    long long left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         deadline - std::chrono::steady_clock::now())
+                         .count();
+    if (left <= 0 || wait_for_input(this->des_out, (int)left) <= 0)
+      return false;
+
+    ssize_t n = read(this->des_out, buffer, sizeof(buffer));
+    if (n > 0)
+      this->des_buffer.append(buffer, n);
+    else if (n == 0 || (errno != EAGAIN && errno != EINTR))
+      return false;
+  }
+}
+
+/* DESODBC:
+  This function launches DES, waits for it to be ready, restores the
+  DES_SNAPSHOT file if any, and starts listening on the broker socket. It
+  returns 'R' when the broker is ready, 'W' when it is ready but the
+  snapshot could not be restored, and 'E' on failure.
+
+  Original author: DESODBC Developer
+*/
+char DESBroker::start() {
+  int to_des[2], from_des[2];
+  if (pipe(to_des) == -1) return 'E';
+  if (pipe(from_des) == -1) return 'E';
+
+  this->des_pid = fork();
+  if (this->des_pid == -1) return 'E';
+  if (this->des_pid == 0) {
+    dup2(to_des[0], STDIN_FILENO);
+    dup2(from_des[1], STDOUT_FILENO);
+    ::close(to_des[0]);
+    ::close(to_des[1]);
+    ::close(from_des[0]);
+    ::close(from_des[1]);
+    if (chdir(this->config.des_working_dir.c_str()) == -1) _exit(127);
+    // What the broker ignores would be ignored by DES too, and so
+    // BROKER_INTERRUPT could not stop a query
+    signal(SIGINT, SIG_DFL);
+    signal(SIGPIPE, SIG_DFL);
+    execlp(this->config.des_exec_path.c_str(),
+           this->config.des_exec_path.c_str(), nullptr);
+    _exit(127);
+  }
+
+  ::close(to_des[0]);
+  ::close(from_des[1]);
+  this->des_in = to_des[1];
+  this->des_out = from_des[0];
+  fcntl(this->des_out, F_SETFL, O_NONBLOCK);
+
+  // Readiness handshake (see DBC::wait_DES_ready)
+  std::string ready = this->next_fence();
+  if (!this->write_des("/tapi /writeln " + ready + "\n") ||
+      !this->read_des_until(ready, nullptr, DES_LAUNCH_TIMEOUT_MS)) {
+    kill(this->des_pid, SIGKILL);
+    waitpid(this->des_pid, nullptr, 0);
+    return 'E';
+  }
+
+  char status = 'R';
+  std::string snapshot;
+  if (!this->config.snapshot_path.empty() &&
+      !quote_DES_path(this->config.snapshot_path, snapshot))
+    status = 'W';
+  else if (!snapshot.empty()) {
+    std::string restored = this->next_fence();
+    std::string output = "";
+    if (!this->write_des("/tapi /restore_state " + snapshot +
+                         "\n/tapi /writeln " + restored + "\n") ||
+        !this->read_des_until(restored, &output, DES_LAUNCH_TIMEOUT_MS)) {
+      kill(this->des_pid, SIGKILL);
+      waitpid(this->des_pid, nullptr, 0);
+      return 'E';
+    }
+    if (output.find("$error") != std::string::npos) status = 'W';
+  }
+
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, this->config.socket_name.c_str(),
+          sizeof(addr.sun_path) - 1);
+
+  this->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  unlink(this->config.socket_name.c_str());
+  if (this->listen_fd == -1 ||
+      bind(this->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) == -1 ||
+      listen(this->listen_fd, SOMAXCONN) == -1) {
+    this->quit_des();
+    return 'E';
+  }
+  // Like the DES pipes, the socket is open to every user
+  chmod(this->config.socket_name.c_str(), 0666);
+  fcntl(this->listen_fd, F_SETFL, O_NONBLOCK);
+
+  return status;
+}
+
+void DESBroker::accept_clients() {
+  while (true) {
+    int fd = accept(this->listen_fd, nullptr, nullptr);
+    if (fd == -1) {
+      if (errno == EINTR) continue;
+      return;
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    this->clients[fd] = BrokerClient();
+  }
+}
+
+void DESBroker::read_client(int fd) {
+  char buffer[BUFFER_SIZE];
+  while (true) {
+    ssize_t n = read(fd, buffer, sizeof(buffer));
+    if (n > 0) {
+      this->clients[fd].in.append(buffer, n);
+    } else if (n == -1 && errno == EINTR) {
+      continue;
+    } else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      break;
+    } else {
+      this->drop_client(fd);
+      return;
+    }
+  }
+  this->handle_requests(fd);
+}
+
+/* DESODBC:
+  This function handles the requests to the broker at the beginning of
+  the lines received from a client. The ones after its DES lines wait for
+  them to be handed to DES, so that they are handled in order.
+
+  Original author: DESODBC Developer
+*/
+void DESBroker::handle_requests(int fd) {
+  auto it = this->clients.find(fd);
+  while (it != this->clients.end()) {
+    std::string &in = it->second.in;
+    size_t nl = in.find('\n');
+    if (nl == std::string::npos) return;
+    std::string line = in.substr(0, nl);
+    if (is_des_line(line)) return;
+    in.erase(0, nl + 1);
+    this->handle_request(fd, line);
+    it = this->clients.find(fd);
+  }
+}
+
+void DESBroker::handle_request(int fd, const std::string &line) {
+  std::istringstream request(line);
+  std::string command;
+  request >> command;
+
+  if (command == BROKER_LOCK) {
+    std::string begin_marker, end_marker;
+    request >> begin_marker >> end_marker;
+    this->clients[fd].lock_reply = begin_marker + "\n" + end_marker + "\n";
+    this->lock_queue.push_back(fd);
+    if (this->lock_queue.size() == 1) this->grant_lock();
+  } else if (command == BROKER_UNLOCK) {
+    bool holder = !this->lock_queue.empty() && this->lock_queue.front() == fd;
+    this->lock_queue.erase(
+        std::remove(this->lock_queue.begin(), this->lock_queue.end(), fd),
+        this->lock_queue.end());
+    if (holder) this->grant_lock();
+  } else if (command == BROKER_INTERRUPT) {
+    if (this->turn_pending && this->turn_fd == fd) kill(this->des_pid, SIGINT);
+  } else if (command == BROKER_TERMINATE) {
+    kill(this->des_pid, SIGKILL);
+  }
+}
+
+void DESBroker::grant_lock() {
+  if (this->lock_queue.empty()) return;
+  BrokerClient &client = this->clients[this->lock_queue.front()];
+  client.out += client.lock_reply;
+}
+
+/* DESODBC:
+  A client that disconnects, even by crashing, gives up the lock and its
+  place in the queue for it. The output of a turn of it that DES is
+  running is discarded.
+
+  Original author: DESODBC Developer
+*/
+void DESBroker::drop_client(int fd) {
+  ::close(fd);
+  this->clients.erase(fd);
+
+  bool holder = !this->lock_queue.empty() && this->lock_queue.front() == fd;
+  this->lock_queue.erase(
+      std::remove(this->lock_queue.begin(), this->lock_queue.end(), fd),
+      this->lock_queue.end());
+  if (holder) this->grant_lock();
+
+  if (this->turn_fd == fd) this->turn_fd = -1;
+}
+
+void DESBroker::write_client(int fd) {
+  std::string &out = this->clients[fd].out;
+  while (!out.empty()) {
+    ssize_t n = write(fd, out.data(), out.size());
+    if (n > 0) {
+      out.erase(0, n);
+    } else if (n == -1 && errno == EINTR) {
+      continue;
+    } else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      return;
+    } else {
+      this->drop_client(fd);
+      return;
+    }
+  }
+}
+
+/* DESODBC:
+  This function gives DES its next turn, if it is idle: the complete DES
+  lines at the beginning of the lines received from the next client, up to
+  PIPELINE_MAX_BYTES (a longer line goes alone), followed by a fence.
+
+  Original author: DESODBC Developer
+*/
+void DESBroker::schedule() {
+  if (this->turn_pending || this->clients.empty()) return;
+
+  auto has_des_line = [](const BrokerClient &client) {
+    size_t nl = client.in.find('\n');
+    return nl != std::string::npos && is_des_line(client.in.substr(0, nl));
+  };
+
+  int fd = -1;
+  if (!this->lock_queue.empty()) {
+    if (has_des_line(this->clients[this->lock_queue.front()]))
+      fd = this->lock_queue.front();
+  } else {
+    // Round-robin, starting after the client of the last turn
+    auto it = this->clients.upper_bound(this->last_turn_fd);
+    for (size_t i = 0; i < this->clients.size(); ++i, ++it) {
+      if (it == this->clients.end()) it = this->clients.begin();
+      if (has_des_line(it->second)) {
+        fd = it->first;
+        break;
+      }
+    }
+  }
+  if (fd == -1) return;
+
+  std::string &in = this->clients[fd].in;
+  size_t taken = 0;
+  while (true) {
+    size_t nl = in.find('\n', taken);
+    if (nl == std::string::npos ||
+        !is_des_line(in.substr(taken, nl - taken)))
+      break;
+    if (taken > 0 && nl + 1 > PIPELINE_MAX_BYTES) break;
+    taken = nl + 1;
+  }
+
+  this->fence = this->next_fence();
+  std::string turn = in.substr(0, taken) + "/tapi /writeln " + this->fence + "\n";
+  in.erase(0, taken);
+
+  this->turn_pending = true;
+  this->turn_fd = this->last_turn_fd = fd;
+  if (!this->write_des(turn)) kill(this->des_pid, SIGKILL);
+
+  this->handle_requests(fd);
+}
+
+/* DESODBC:
+  This function sends the DES output read to the client of the current
+  turn, line by line, until the fence of the turn. It returns false when
+  DES has finished.
+
+  Original author: DESODBC Developer
+*/
+bool DESBroker::read_des() {
+  char buffer[BUFFER_SIZE];
+  bool finished = false;
+
+  while (true) {
+    ssize_t n = read(this->des_out, buffer, sizeof(buffer));
+    if (n > 0) {
+      this->des_buffer.append(buffer, n);
+    } else if (n == -1 && errno == EINTR) {
+      continue;
+    } else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      break;
+    } else {
+      finished = true;
+      break;
+    }
+  }
+
+  size_t start = 0;
+  size_t nl;
+  while ((nl = this->des_buffer.find('\n', start)) != std::string::npos) {
+    std::string_view line(this->des_buffer.data() + start, nl - start);
+    size_t marker_pos = 0;
+    bool fence_line = this->turn_pending &&
+                      ends_with_marker(line, this->fence, marker_pos);
+    size_t length = fence_line ? marker_pos : nl + 1 - start;
+
+    // Output out of any turn is nobody's
+    if (this->turn_pending && this->turn_fd != -1)
+      this->clients[this->turn_fd].out.append(this->des_buffer, start, length);
+
+    start = nl + 1;
+    if (fence_line) {
+      this->turn_pending = false;
+      this->turn_fd = -1;
+    }
+  }
+  this->des_buffer.erase(0, start);
+
+  return !finished;
+}
+
+/* DESODBC:
+  This function quits DES and stops listening, unless a new client is
+  waiting to be accepted. The spawners of brokers hold the broker lock
+  file, so no client can find the socket gone and launch a new broker
+  before this one has removed it.
+
+  Original author: DESODBC Developer
+*/
+bool DESBroker::try_shutdown() {
+  int lock_fd = open(this->config.lock_name.c_str(), O_RDWR | O_CREAT, 0666);
+  if (lock_fd != -1)
+    while (flock(lock_fd, LOCK_EX) == -1 && errno == EINTR);
+
+  if (wait_for_input(this->listen_fd, 0) > 0) {
+    if (lock_fd != -1) ::close(lock_fd);
+    return false;
+  }
+
+  unlink(this->config.socket_name.c_str());
+  ::close(this->listen_fd);
+  if (lock_fd != -1) ::close(lock_fd);
+
+  this->quit_des();
+  return true;
+}
+
+void DESBroker::quit_des() {
+  this->write_des("/tapi /q\n");
+  ::close(this->des_in);
+
+  for (int waited = 0; waited < BROKER_QUIT_TIMEOUT_MS; waited += 100) {
+    if (waitpid(this->des_pid, nullptr, WNOHANG) != 0) return;
+    usleep(100000);
+  }
+  kill(this->des_pid, SIGKILL);
+  waitpid(this->des_pid, nullptr, 0);
+}
+
+/* DESODBC:
+  Main loop of the broker. It ends when DES finishes, or once it has had
+  no clients for DES_LINGER seconds.
+
+  Original author: DESODBC Developer
+*/
+void DESBroker::run() {
+  auto idle_since = std::chrono::steady_clock::now();
+
+  while (true) {
+    std::vector<struct pollfd> fds;
+    fds.push_back({this->listen_fd, POLLIN, 0});
+    fds.push_back({this->des_out, POLLIN, 0});
+    for (auto &client : this->clients)
+      fds.push_back({client.first,
+                     (short)(POLLIN | (client.second.out.empty() ? 0 : POLLOUT)),
+                     0});
+
+    int timeout = -1;
+    if (this->clients.empty() && !this->turn_pending) {
+      long long left =
+          this->config.linger * 1000LL -
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::steady_clock::now() - idle_since)
+              .count();
+      if (left <= 0) {
+        if (this->try_shutdown()) return;
+        left = 0;
+      }
+      timeout = (int)std::min<long long>(left, INT_MAX);
+    }
+
+    int ready = poll(fds.data(), fds.size(), timeout);
+    if (ready == -1 && errno != EINTR) break;
+    if (ready <= 0) continue;
+
+    if (fds[1].revents && !this->read_des()) break;
+
+    for (size_t i = 2; i < fds.size(); ++i) {
+      int fd = fds[i].fd;
+      if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) this->read_client(fd);
+      if (this->clients.count(fd) && (fds[i].revents & POLLOUT))
+        this->write_client(fd);
+    }
+
+    if (fds[0].revents & POLLIN) this->accept_clients();
+
+    this->schedule();
+
+    // The output just read may already fit in the sockets
+    for (auto it = this->clients.begin(); it != this->clients.end();) {
+      int fd = (it++)->first;
+      if (!this->clients[fd].out.empty()) this->write_client(fd);
+    }
+
+    if (!this->clients.empty() || this->turn_pending)
+      idle_since = std::chrono::steady_clock::now();
+  }
+
+  // DES has finished: its clients cannot go on
+  int lock_fd = open(this->config.lock_name.c_str(), O_RDWR | O_CREAT, 0666);
+  if (lock_fd != -1)
+    while (flock(lock_fd, LOCK_EX) == -1 && errno == EINTR);
+  unlink(this->config.socket_name.c_str());
+  ::close(this->listen_fd);
+  if (lock_fd != -1) ::close(lock_fd);
+
+  for (auto &client : this->clients) ::close(client.first);
+  waitpid(this->des_pid, nullptr, 0);
+}
+
+}  // namespace
+
+/* DESODBC:
+  Usage: desodbc-broker <ready fd> <DES executable> <DES working directory>
+                        <socket> <lock file> <linger seconds> [<snapshot>]
+
+  The broker reports through the inherited ready fd whether it started
+  (see DESBroker::start). The process launched by the driver only forks
+  the broker away and exits, so that the broker outlives the process of
+  the connection without being a child of it.
+
+  Original author: DESODBC Developer
+*/
+int main(int argc, char **argv) {
+  if (argc < 7 || argc > 8) {
+    fprintf(stderr,
+            "Usage: %s <ready fd> <DES executable> <DES working directory> "
+            "<socket> <lock file> <linger seconds> [<snapshot>]\n",
+            argv[0]);
+    return 2;
+  }
+
+  int ready = atoi(argv[1]);
+  BrokerConfig config;
+  config.des_exec_path = argv[2];
+  config.des_working_dir = argv[3];
+  config.socket_name = argv[4];
+  config.lock_name = argv[5];
+  config.linger = atoi(argv[6]);
+  if (argc == 8) config.snapshot_path = argv[7];
+
+  pid_t pid = fork();
+  if (pid == -1) {
+    char failed = 'E';
+    if (write(ready, &failed, 1) == -1) return 1;
+    return 1;
+  }
+  if (pid != 0) return 0;
+
+  setsid();
+  signal(SIGPIPE, SIG_IGN);
+  signal(SIGINT, SIG_IGN);
+
+  // We keep nothing of the process of the connection but the ready pipe
+  long max_fd = sysconf(_SC_OPEN_MAX);
+  if (max_fd < 0 || max_fd > 65536) max_fd = 65536;
+  for (int fd = 3; fd < max_fd; ++fd)
+    if (fd != ready) ::close(fd);
+
+  int null_fd = open("/dev/null", O_RDWR);
+  if (null_fd != -1) {
+    dup2(null_fd, STDIN_FILENO);
+    dup2(null_fd, STDOUT_FILENO);
+    dup2(null_fd, STDERR_FILENO);
+    if (null_fd > STDERR_FILENO && null_fd != ready) ::close(null_fd);
+  }
+
+  DESBroker broker(config);
+  char started = broker.start();
+  if (write(ready, &started, 1) == -1 || started == 'E') return 1;
+  ::close(ready);
+
+  broker.run();
+  return 0;
+}
@@ -75,6 +75,7 @@ SQLColAttribute(SQLHSTMT hstmt, SQLUSMALLINT column,
 #endif
                )
 {
+  CHECK_STMT_IDLE(hstmt);
   LOCK_STMT(hstmt);
   return SQLColAttributeImpl(hstmt, column, field, char_attr, char_attr_max,
                              char_attr_len, num_attr);
@@ -125,6 +126,7 @@ SQLColumnPrivileges(SQLHSTMT hstmt,
                     SQLCHAR *table, SQLSMALLINT table_len,
                     SQLCHAR *column, SQLSMALLINT column_len)
 {
+  CHECK_STMT_IDLE(hstmt);
   return ((STMT*)hstmt)->set_error("IM001", "DESODBC does not support this function");
 }
 
@@ -138,6 +140,7 @@ SQLColumns(SQLHSTMT hstmt, SQLCHAR *catalog, SQLSMALLINT catalog_len,
            SQLCHAR *table, SQLSMALLINT table_len,
            SQLCHAR *column, SQLSMALLINT column_len)
 {
+  CHECK_STMT_IDLE(hstmt);
   SQLRETURN rc;
   DBC *dbc;
 
@@ -195,6 +198,7 @@ SQLDescribeCol(SQLHSTMT hstmt, SQLUSMALLINT column,
                SQLSMALLINT *type, SQLULEN *size, SQLSMALLINT *scale,
                SQLSMALLINT *nullable)
 {
+  CHECK_STMT_IDLE(hstmt);
   STMT *stmt= (STMT *)hstmt;
   SQLCHAR *value= NULL;
   SQLINTEGER len= SQL_NTS;
@@ -306,10 +310,24 @@ SQLExecDirect(SQLHSTMT hstmt, SQLCHAR *str, SQLINTEGER str_len)
 {
   int error;
 
+  CHECK_HANDLE(hstmt);
+  STMT *stmt = (STMT *)hstmt;
+
+  /* DESODBC: the statement is locked by the worker while it is executed */
+  if (stmt->async_result.valid())
+    return stmt->poll_async(SQL_API_SQLEXECDIRECT);
+
   LOCK_STMT(hstmt);
 
   if ((error= SQLPrepareImpl(hstmt, str, str_len, false)))
     return error;
+
+  if (stmt->stmt_options.async_enable == SQL_ASYNC_ENABLE_ON)
+    return stmt->start_async(SQL_API_SQLEXECDIRECT, [stmt]() -> SQLRETURN {
+      LOCK_STMT(stmt);
+      return DES_SQLExecute(stmt);
+    });
+
   error= DES_SQLExecute((STMT *)hstmt);
 
   return error;
@@ -328,6 +346,7 @@ SQLForeignKeys(SQLHSTMT hstmt,
                SQLCHAR *fk_schema, SQLSMALLINT fk_schema_len,
                SQLCHAR *fk_table, SQLSMALLINT fk_table_len)
 {
+  CHECK_STMT_IDLE(hstmt);
   SQLRETURN rc;
   DBC *dbc;
 
@@ -407,6 +426,7 @@ SQLRETURN SQL_API
 SQLGetCursorName(SQLHSTMT hstmt, SQLCHAR *cursor, SQLSMALLINT cursor_max,
                  SQLSMALLINT *cursor_len)
 {
+  CHECK_STMT_IDLE(hstmt);
   STMT *stmt= (STMT *)hstmt;
   SQLCHAR *name;
 
@@ -615,6 +635,7 @@ SQLRETURN SQL_API
 SQLGetStmtAttr(SQLHSTMT hstmt, SQLINTEGER attribute, SQLPOINTER value,
                 SQLINTEGER value_max, SQLINTEGER *value_len)
 {
+  CHECK_STMT_IDLE(hstmt);
   LOCK_STMT(hstmt);
 
   /* Nothing special to do, since we don't have any string stmt attribs */
@@ -628,6 +649,7 @@ SQLGetStmtAttr(SQLHSTMT hstmt, SQLINTEGER attribute, SQLPOINTER value,
 SQLRETURN SQL_API
 SQLGetTypeInfo(SQLHSTMT hstmt, SQLSMALLINT type)
 {
+  CHECK_STMT_IDLE(hstmt);
   LOCK_STMT(hstmt);
   SQLRETURN rc;
   try {
@@ -681,6 +703,7 @@ SQLNativeSql(SQLHDBC hdbc, SQLCHAR *in, SQLINTEGER in_len,
 SQLRETURN SQL_API
 SQLPrepare(SQLHSTMT hstmt, SQLCHAR *str, SQLINTEGER str_len)
 {
+  CHECK_STMT_IDLE(hstmt);
   LOCK_STMT(hstmt);
 
   return SQLPrepareImpl(hstmt, str, str_len, true);
@@ -711,6 +734,7 @@ SQLPrimaryKeys(SQLHSTMT hstmt,
                SQLCHAR *schema, SQLSMALLINT schema_len,
                SQLCHAR *table, SQLSMALLINT table_len)
 {
+  CHECK_STMT_IDLE(hstmt);
   SQLRETURN rc;
   DBC *dbc;
 
@@ -739,6 +763,7 @@ SQLProcedureColumns(SQLHSTMT hstmt,
                     SQLCHAR *proc, SQLSMALLINT proc_len,
                     SQLCHAR *column, SQLSMALLINT column_len)
 {
+  CHECK_STMT_IDLE(hstmt);
   return ((STMT *)hstmt)
       ->set_error("IM001", "DESODBC does not support this function");
 }
@@ -753,6 +778,7 @@ SQLProcedures(SQLHSTMT hstmt,
               SQLCHAR *schema, SQLSMALLINT schema_len,
               SQLCHAR *proc, SQLSMALLINT proc_len)
 {
+  CHECK_STMT_IDLE(hstmt);
   return ((STMT *)hstmt)
       ->set_error("IM001", "DESODBC does not support this function");
 }
@@ -788,6 +814,7 @@ SQLSetConnectAttrImpl(SQLHDBC hdbc, SQLINTEGER attribute,
 SQLRETURN SQL_API
 SQLSetCursorName(SQLHSTMT hstmt, SQLCHAR *name, SQLSMALLINT name_len)
 {
+  CHECK_STMT_IDLE(hstmt);
   STMT *stmt= (STMT *)hstmt;
   SQLINTEGER len= name_len;
   uint errors= 0;
@@ -801,6 +828,7 @@ SQLRETURN SQL_API
 SQLSetStmtAttr(SQLHSTMT hstmt, SQLINTEGER attribute,
                SQLPOINTER value, SQLINTEGER value_len)
 {
+  CHECK_STMT_IDLE(hstmt);
   LOCK_STMT(hstmt);
 
   /* Nothing special to do, since we don't have any string stmt attribs */
@@ -818,6 +846,7 @@ SQLSpecialColumns(SQLHSTMT hstmt, SQLUSMALLINT type,
                   SQLCHAR *table, SQLSMALLINT table_len,
                   SQLUSMALLINT scope, SQLUSMALLINT nullable)
 {
+  CHECK_STMT_IDLE(hstmt);
   SQLRETURN rc;
   DBC *dbc;
 
@@ -846,6 +875,7 @@ SQLStatistics(SQLHSTMT hstmt,
               SQLCHAR *table, SQLSMALLINT table_len,
               SQLUSMALLINT unique, SQLUSMALLINT accuracy)
 {
+  CHECK_STMT_IDLE(hstmt);
   SQLRETURN rc;
   DBC *dbc;
 
@@ -872,6 +902,7 @@ SQLTablePrivileges(SQLHSTMT hstmt,
                    SQLCHAR *schema, SQLSMALLINT schema_len,
                    SQLCHAR *table, SQLSMALLINT table_len)
 {
+  CHECK_STMT_IDLE(hstmt);
   return ((STMT *)hstmt)
       ->set_error("IM001", "DESODBC does not support this function");
 }
@@ -887,6 +918,7 @@ SQLTables(SQLHSTMT hstmt,
           SQLCHAR *table, SQLSMALLINT table_len,
           SQLCHAR *type, SQLSMALLINT type_len)
 {
+  CHECK_STMT_IDLE(hstmt);
   SQLRETURN rc;
   DBC *dbc;
 
@@ -0,0 +1,268 @@
+// Copyright (c) 2025 Sergio Miguel Garcia Jimenez <segarc21@ucm.es>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0, as
+// published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+// ---------------------------------------------------------
+// This file is part of DESODBC, an ODBC Driver of the open-source DBMS
+// Datalog Educational System (DES) (see https://des.sourceforge.io/),
+// written by Sergio Miguel Garcia Jimenez <segarc21@ucm.es>, hereinafter
+// the DESODBC developer.
+// ---------------------------------------------------------
+
+/**
+  @file  broker.cc
+  @brief Client side of the DES broker (DES_BROKER option): launching it,
+         connecting to it and taking its lock. The broker itself is the
+         desodbc-broker executable (see broker/desodbc-broker.cc).
+*/
+
+#include "driver.h"
+
+#ifndef _WIN32
+#include <sys/file.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <dlfcn.h>
+#include <spawn.h>
+
+extern char **environ;
+
+/* DESODBC:
+  Name of the executable of the DES broker. It is looked for next to the
+  driver, then in the bin directory beside the one of the driver (as
+  installed, and in the build tree), and last in the PATH.
+
+  Original author: DESODBC Developer
+*/
+#define DES_BROKER_EXEC "desodbc-broker"
+
+namespace {
+
+/* DESODBC:
+  This function connects to the broker socket, returning -1 if there is
+  no broker listening on it.
+
+  Original author: DESODBC Developer
+*/
+int connect_to_broker(const char *socket_name) {
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, socket_name, sizeof(addr.sun_path) - 1);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd == -1) return -1;
+
+  int ret;
+  while ((ret = ::connect(fd, (struct sockaddr *)&addr, sizeof(addr))) == -1 &&
+         errno == EINTR);
+  if (ret == -1) {
+    ::close(fd);
+    return -1;
+  }
+
+  fcntl(fd, F_SETFD, FD_CLOEXEC);
+  fcntl(fd, F_SETFL, O_NONBLOCK);
+  return fd;
+}
+
+/* DESODBC:
+  This function returns the path of the DES broker executable (see
+  DES_BROKER_EXEC).
+
+  Original author: DESODBC Developer
+*/
+std::string broker_exec_path() {
+  Dl_info info;
+  if (dladdr((void *)&connect_to_broker, &info) && info.dli_fname) {
+    std::string dir = info.dli_fname;
+    dir.erase(dir.rfind('/') == std::string::npos ? 0 : dir.rfind('/') + 1);
+    for (const std::string &candidate :
+         {dir + DES_BROKER_EXEC, dir + "../bin/" DES_BROKER_EXEC}) {
+      if (access(candidate.c_str(), X_OK) == 0) return candidate;
+    }
+  }
+  return DES_BROKER_EXEC;
+}
+
+}  // namespace
+
+/* DESODBC:
+  This function launches the broker of the connection, a desodbc-broker
+  process that daemonizes itself so that it outlives the process of the
+  connection, and waits until it is ready or it fails. It must be called
+  with the broker lock file held. status is the state reported by the
+  broker: 'R' (ready), 'W' (ready, but the snapshot was not restored) or
+  'E' (failed).
+
+  Original author: DESODBC Developer
+*/
+SQLRETURN DBC::launch_DES_broker(const char *des_exec_path,
+                                 const char *des_working_dir, char &status) {
+  int ready[2];
+  if (pipe(ready) == -1)
+    return this->set_unix_error("Failed to create the DES broker pipe", true);
+  fcntl(ready[0], F_SETFD, FD_CLOEXEC);
+
+  std::string exec_path = broker_exec_path();
+  std::vector<std::string> args = {exec_path,
+                                   std::to_string(ready[1]),
+                                   des_exec_path,
+                                   des_working_dir,
+                                   this->BROKER_SOCKET_NAME,
+                                   this->BROKER_LOCK_NAME,
+                                   std::to_string(this->linger)};
+  if (!this->snapshot_path.empty()) args.push_back(this->snapshot_path);
+
+  std::vector<char *> argv;
+  for (std::string &arg : args) argv.push_back(&arg[0]);
+  argv.push_back(nullptr);
+
+  // Neither the signal mask of this thread nor what the application
+  // ignores is passed on
+  sigset_t no_signals, default_signals;
+  sigemptyset(&no_signals);
+  sigemptyset(&default_signals);
+  sigaddset(&default_signals, SIGINT);
+  sigaddset(&default_signals, SIGPIPE);
+
+  posix_spawnattr_t attr;
+  posix_spawnattr_init(&attr);
+  posix_spawnattr_setsigmask(&attr, &no_signals);
+  posix_spawnattr_setsigdefault(&attr, &default_signals);
+  posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+  pid_t pid;
+  int err = posix_spawnp(&pid, exec_path.c_str(), nullptr, &attr, argv.data(),
+                         environ);
+  posix_spawnattr_destroy(&attr);
+  ::close(ready[1]);
+  if (err != 0) {
+    ::close(ready[0]);
+    errno = err;
+    return this->set_unix_error("Failed to launch the DES broker " + exec_path,
+                                true);
+  }
+
+  // It exits as soon as the broker is forked away
+  while (waitpid(pid, nullptr, 0) == -1 && errno == EINTR);
+
+  status = 'E';
+  if (wait_for_pipe_input(ready[0], DES_LAUNCH_TIMEOUT_MS * 2) > 0 &&
+      read(ready[0], &status, 1) != 1)
+    status = 'E';
+  ::close(ready[0]);
+
+  if (status == 'E')
+    return this->set_error("08001", "Failed to launch DES through its broker");
+  return SQL_SUCCESS;
+}
+
+/* DESODBC:
+  This function connects to the DES broker of the connection (DES_BROKER),
+  launching it first if it is not running. Launches are serialized with
+  the broker lock file, which is released by the system if its holder
+  crashes.
+
+  Original author: DESODBC Developer
+*/
+SQLRETURN DBC::connect_broker(const char *des_exec_path,
+                              const char *des_working_dir) {
+  SQLRETURN rc = SQL_SUCCESS;
+  char status = 'R';
+
+  int fd = connect_to_broker(this->BROKER_SOCKET_NAME);
+  if (fd == -1) {
+    int lock_fd = open(this->BROKER_LOCK_NAME, O_RDWR | O_CREAT, 0666);
+    if (lock_fd == -1)
+      return this->set_unix_error(
+          "Failed to open " + std::string(this->BROKER_LOCK_NAME), true);
+    while (flock(lock_fd, LOCK_EX) == -1 && errno == EINTR);
+
+    fd = connect_to_broker(this->BROKER_SOCKET_NAME);
+    if (fd == -1) {
+      auto launch_start = std::chrono::steady_clock::now();
+      rc = this->launch_DES_broker(des_exec_path, des_working_dir, status);
+      if (rc == SQL_SUCCESS) fd = connect_to_broker(this->BROKER_SOCKET_NAME);
+      this->launch_time_ms =
+          (SQLUINTEGER)std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::steady_clock::now() - launch_start)
+              .count();
+    }
+
+    ::close(lock_fd);
+    if (rc != SQL_SUCCESS) return rc;
+    if (fd == -1)
+      return this->set_unix_error("Failed to connect to the DES broker " +
+                                      std::string(this->BROKER_SOCKET_NAME),
+                                  true);
+  }
+
+  this->driver_to_des_in_wpipe = fd;
+  this->driver_to_des_out_rpipe = fd;
+  this->connected = true;
+
+  if (status == 'W') {
+    std::string msg =
+        "Could not restore the DES snapshot " + this->snapshot_path;
+    this->set_error("01000", msg.c_str());
+    return SQL_SUCCESS_WITH_INFO;
+  }
+  return SQL_SUCCESS;
+}
+
+/* DESODBC:
+  This function gets the lock of the DES broker, which plays the part of
+  the query mutex: the broker answers with the markers we send once we
+  hold it. If it does not in MUTEX_TIMEOUT_SECONDS, we give up our place
+  in the queue; a late answer is skipped by the next command.
+
+  Original author: DESODBC Developer
+*/
+SQLRETURN DBC::get_broker_lock() {
+  std::pair<std::string, std::string> markers = this->next_reply_markers();
+  SQLRETURN ret = this->write_DES_input(std::string(BROKER_LOCK) + " " +
+                                        markers.first + " " + markers.second +
+                                        "\n");
+  if (ret != SQL_SUCCESS) return ret;
+
+  // Only the deadline counts, as when skipping an abandoned reply
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::seconds(MUTEX_TIMEOUT_SECONDS);
+  auto previous_deadline = this->reply_deadline;
+  bool previous_resyncing = this->resyncing;
+  DESReplyDiscard discard;
+  this->resyncing = true;
+  this->reply_deadline = deadline;
+  ret = this->read_DES_reply(markers.first, markers.second, discard);
+  this->resyncing = previous_resyncing;
+  this->reply_deadline = previous_deadline;
+
+  if (ret != SQL_SUCCESS) {
+    if (std::chrono::steady_clock::now() < deadline) return ret;
+    this->release_broker_lock();
+    return this->set_unix_error(
+        "Fetching the query lock of the DES broker timed-out", false);
+  }
+  return SQL_SUCCESS;
+}
+
+/* DESODBC:
+  Original author: DESODBC Developer
+*/
+SQLRETURN DBC::release_broker_lock() {
+  return this->write_DES_input(std::string(BROKER_UNLOCK) + "\n");
+}
+#endif
@@ -371,7 +371,7 @@ SQLRETURN SQL_API DES_SQLColumns(SQLHSTMT hstmt, SQLCHAR *catalog_name,
     dbc->release_query_mutex();
     return rc;
   }
-  std::string previous_db = getLines(current_db_output)[0];
+  std::string previous_db(getLines(current_db_output)[0]);
 
   std::string catalog_name_str =
       get_prepared_arg(stmt, catalog_name, catalog_len);
@@ -514,7 +514,7 @@ SQLRETURN SQL_API DES_SQLStatistics(SQLHSTMT hstmt, SQLCHAR *catalog_name,
     dbc->release_query_mutex();
     return rc;
   }
-  std::string previous_db = getLines(current_db_output)[0];
+  std::string previous_db(getLines(current_db_output)[0]);
 
   std::string catalog_name_str = get_catalog(stmt, catalog_name, catalog_len);
 
@@ -651,7 +651,7 @@ SQLRETURN SQL_API DES_SQLSpecialColumns(
     dbc->release_query_mutex();
     return rc;
   }
-  std::string previous_db = getLines(current_db_output)[0];
+  std::string previous_db(getLines(current_db_output)[0]);
 
   pair = dbc->send_query_and_read("/use_db $des");
   rc = pair.first;
@@ -777,21 +777,16 @@ SQLRETURN SQL_API DES_SQLPrimaryKeys(SQLHSTMT hstmt, SQLCHAR *catalog_name,
     return rc;
   }
 
+  // The primary keys are parsed from main_output without asking DES again
+  rc = dbc->release_query_mutex();
+  if (rc != SQL_SUCCESS && rc != SQL_SUCCESS_WITH_INFO) return rc;
+
   stmt->params_for_table.catalog_name = catalog_name_str;
   stmt->params_for_table.table_name = table_name_str;
   stmt->type = SQLPRIMARYKEYS;
   stmt->last_output = main_output;
 
-  rc = stmt->build_results();
-  if (rc != SQL_SUCCESS && rc != SQL_SUCCESS_WITH_INFO) {
-    dbc->release_query_mutex();
-    return rc;
-  }
-
-  rc = dbc->release_query_mutex();
-  if (rc != SQL_SUCCESS && rc != SQL_SUCCESS_WITH_INFO) return rc;
-
-  return rc;
+  return stmt->build_results();
 }
 
 /*
@@ -965,23 +960,20 @@ SQLRETURN SQL_API DES_SQLForeignKeys(
   std::string main_query = "/dbschema ";
   main_query += pk_catalog_str;  // DESODBC: could also be fk_catalog_str. Both
                                  // values are "$des".
-  pair = dbc->send_query_and_read(main_query);
-  rc = pair.first;
-  std::string main_output = pair.second;
-
   rc = dbc->get_query_mutex();
   if (rc != SQL_SUCCESS && rc != SQL_SUCCESS_WITH_INFO) return rc;
 
-  stmt->last_output = main_output;
-
-  rc = stmt->build_results();
-  if (rc != SQL_SUCCESS && rc != SQL_SUCCESS_WITH_INFO) {
-    dbc->release_query_mutex();
-    return rc;
-  }
+  pair = dbc->send_query_and_read(main_query);
+  std::string main_output = pair.second;
 
+  // The foreign keys are parsed from main_output without asking DES again
   rc = dbc->release_query_mutex();
   if (rc != SQL_SUCCESS && rc != SQL_SUCCESS_WITH_INFO) return rc;
 
-  return rc;
+  rc = pair.first;
+  if (rc != SQL_SUCCESS && rc != SQL_SUCCESS_WITH_INFO) return rc;
+
+  stmt->last_output = main_output;
+
+  return stmt->build_results();
 }
\ No newline at end of file
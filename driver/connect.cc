@@ -62,8 +62,16 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
+#include <chrono>
+#include <climits>
 #include <cstdio>
 #include <iostream>
+#ifndef __APPLE__
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <new>
+#endif
 #endif
 
 #ifndef CLIENT_NO_SCHEMA
@@ -101,10 +109,14 @@ LPCSTR DBC::build_name(const char *name_base) {
   Original author: DESODBC Developer
 */
 void DBC::get_concurrent_objects(const wchar_t *des_exec_path,
-                          const wchar_t *des_working_dir) {
+                          const wchar_t *des_working_dir, int slot) {
   std::wstring des_exec_path_wstr(des_exec_path);
   std::wstring des_working_dir_wstr(des_working_dir);
 
+  // Each process of a pool has its own IPC objects. The first one keeps
+  // the names used without a pool.
+  if (slot > 0) des_working_dir_wstr += L"#" + std::to_wstring(slot);
+
   this->connection_hash = std::to_string(wstr_hasher(des_working_dir_wstr));
 
   this->exec_hash_int = wstr_hasher(des_exec_path_wstr);
@@ -143,10 +155,14 @@ const char * DBC::build_name(const char *name_base) {
   Original author: DESODBC Developer
 */
 void DBC::get_concurrent_objects(const char *des_exec_path,
-                          const char *des_working_dir) {
+                          const char *des_working_dir, int slot) {
   std::string des_exec_path_str(des_exec_path);
   std::string des_working_dir_str(des_working_dir);
 
+  // Each process of a pool has its own IPC objects. The first one keeps
+  // the names used without a pool.
+  if (slot > 0) des_working_dir_str += "#" + std::to_string(slot);
+
   this->connection_hash = std::to_string(str_hasher(des_working_dir_str));
 
   this->connection_hash_int = 0;
@@ -167,9 +183,59 @@ void DBC::get_concurrent_objects(const char *des_exec_path,
   this->QUERY_MUTEX_NAME = build_name(QUERY_MUTEX_NAME_BASE);
   this->IN_WPIPE_NAME = build_name(IN_WPIPE_NAME_BASE);
   this->OUT_RPIPE_NAME = build_name(OUT_RPIPE_NAME_BASE);
+  this->BROKER_SOCKET_NAME = build_name(BROKER_SOCKET_NAME_BASE);
+  this->BROKER_LOCK_NAME = build_name(BROKER_LOCK_NAME_BASE);
 }
 #endif
 
+/* DESODBC:
+  Connections of this process to each process of each pool of DES
+  processes, by pool key and slot.
+
+  Original author: DESODBC Developer
+*/
+static std::mutex pool_load_mutex;
+static std::map<std::string, std::vector<int>> pool_load;
+
+/* DESODBC:
+  This function routes the connection to the least loaded DES process of
+  its pool (the one with fewer connections from this process). With a
+  pool of one process, the default, it is always the global DES process.
+
+  Original author: DESODBC Developer
+*/
+void DBC::acquire_pool_slot(int pool_size) {
+  this->release_pool_slot();
+
+  if (pool_size < 1) pool_size = 1;
+  if (pool_size > MAX_DES_POOL_SIZE) pool_size = MAX_DES_POOL_SIZE;
+
+  std::lock_guard<std::mutex> guard(pool_load_mutex);
+  std::vector<int> &load = pool_load[this->pool_key];
+  if (load.size() < (size_t)pool_size) load.resize(pool_size, 0);
+
+  int slot = 0;
+  for (int i = 1; i < pool_size; ++i)
+    if (load[i] < load[slot]) slot = i;
+
+  load[slot]++;
+  this->pool_slot = slot;
+}
+
+/* DESODBC:
+  Original author: DESODBC Developer
+*/
+void DBC::release_pool_slot() {
+  if (this->pool_slot < 0) return;
+
+  std::lock_guard<std::mutex> guard(pool_load_mutex);
+  auto it = pool_load.find(this->pool_key);
+  if (it != pool_load.end() && it->second[this->pool_slot] > 0)
+    it->second[this->pool_slot]--;
+
+  this->pool_slot = -1;
+}
+
 /* DESODBC:
   This function creates the pipes for the
   DES process we are about to launch.
@@ -342,38 +408,10 @@ SQLRETURN DBC::create_DES_process(SQLWCHAR *des_exec_path,
   // We save the PID of the DES global process
   this->shmem->DES_pid = this->process_info.dwProcessId;
 
-  /* Now, the DES process has just been created. However, we need to remove all
-  the startup messages from DES that are allocated into the STDOUT read pipe. We
-  read from this pipe using the ReadFile function (fileapi.h), and it writes it
-  into a buffer. When the buffer contains "DES>", the startup messages will have
-  ended. */
-
-  CHAR buffer[BUFFER_SIZE];  // standard size
-  DWORD bytes_read;
-
-  bool finished_reading = false;
-  std::string complete_reading_str = "";
-  while (!finished_reading) {
-    BOOL success =
-        ReadFile(this->driver_to_des_out_rpipe, buffer,
-                 sizeof(buffer) - sizeof(CHAR), &bytes_read,
-                 NULL); /* we don't write the final CHAR so as to put the '\0'
-                           char, like we will see.
-                           the final argument must be not null only when
-                           the pipe was created with overlapping */
-    if (!success) {
-      return this->set_win_error("Failed to read from DES output pipe", true);
-    }
-
-    buffer[bytes_read] =
-        '/0';  // we need it to be zero-terminated, as advised by a warning when
-               // tring to assign the char[] to a new std::string
-    std::string buffer_str = buffer;
-
-    complete_reading_str += buffer_str;
-
-    finished_reading = (bytes_read < BUFFER_SIZE - 1);
-  }
+  /* Now, the DES process has just been created. Its startup messages are
+  skipped by the readiness handshake. */
+  SQLRETURN ret = this->wait_DES_ready();
+  if (ret != SQL_SUCCESS) return ret;
 
   this->shmem->des_process_created = true;
   return SQL_SUCCESS;
@@ -441,35 +479,11 @@ SQLRETURN DBC::create_DES_process(const char *des_exec_path,
     ret = get_DES_process_pipes();
     if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) return ret;
 
-    char buffer[4096];
-    ssize_t bytes_read = 0;
-
-    bool finished_reading = false;
-    std::string complete_reading_str = "";
-    while (!finished_reading) {
-      int ms = 0;
-      while (ms < MAX_OUTPUT_WAIT_MS && bytes_read == 0) {
-        usleep(10000);
-        ioctl(this->driver_to_des_out_rpipe, FIONREAD, &bytes_read);
-        ms += 10;
-      }
-      if (bytes_read > 0) {
-        bytes_read =
-            read(this->driver_to_des_out_rpipe, buffer, sizeof(buffer));
-        if (bytes_read == -1) {
-          return this->set_unix_error("Failed to read DES output pipe", true);
-        }
-        buffer[bytes_read] =
-            '/0';  // we need it to be zero-terminated, as advised by a warning
-                   // when tring to assign the char[] to a new std::string
-        std::string buffer_str = buffer;
-
-        complete_reading_str += buffer_str;
-
-        finished_reading = (bytes_read < BUFFER_SIZE - 1);
-      } else
-        finished_reading = true;
-    }
+    /* We wait for DES to be ready, which also skips its startup
+    messages. */
+    ret = this->wait_DES_ready();
+    if (ret != SQL_SUCCESS) return ret;
+
     this->shmem->des_process_created = true;
   }
 
@@ -477,6 +491,54 @@ SQLRETURN DBC::create_DES_process(const char *des_exec_path,
 }
 #endif
 
+/* DESODBC:
+  Original author: DESODBC Developer
+*/
+static SQLUINTEGER elapsed_ms(std::chrono::steady_clock::time_point start) {
+  return (SQLUINTEGER)std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+/* DESODBC:
+  This function waits for a newly launched DES process to be ready to
+  take commands. Rather than guessing when its startup messages are over,
+  we send it an empty framed command (just both reply markers) and wait
+  for the end marker; everything printed before the begin marker, the
+  startup messages included, is discarded. If DES does not answer in
+  DES_LAUNCH_TIMEOUT_MS, it is terminated.
+
+  Original author: DESODBC Developer
+*/
+SQLRETURN DBC::wait_DES_ready() {
+  std::pair<std::string, std::string> markers = this->next_reply_markers();
+  std::string handshake = "/tapi /writeln " + markers.first + '\n' +
+                          "/tapi /writeln " + markers.second + '\n';
+
+  SQLRETURN ret = this->write_DES_input(handshake);
+  if (ret != SQL_SUCCESS) return ret;
+
+  // As when skipping an abandoned reply, only the deadline counts: there
+  // is no command to interrupt yet.
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(DES_LAUNCH_TIMEOUT_MS);
+  DESReplyDiscard discard;
+  this->resyncing = true;
+  this->reply_deadline = deadline;
+  ret = this->read_DES_reply(markers.first, markers.second, discard);
+  this->resyncing = false;
+  this->reply_deadline = std::chrono::steady_clock::time_point::max();
+
+  if (ret != SQL_SUCCESS) {
+    this->terminate_DES();
+    if (std::chrono::steady_clock::now() >= deadline)
+      return this->set_error("HYT00", "DES did not start up in time");
+    return ret;
+  }
+
+  return SQL_SUCCESS;
+}
+
 /* DESODBC:
   This function gets the input/output pipes
   from the already launched global DES process.
@@ -735,42 +797,51 @@ SQLRETURN DBC::release_mutex(HANDLE h, const std::string &name) {
 }
 #else
 /* DESODBC:
-  This function gets a generic mutex
-  in Unix-like systems.
+  This function waits for a semaphore for MUTEX_TIMEOUT_SECONDS at most,
+  returning false if it timed-out. It neither allocates memory nor records
+  errors, so a forked child may call it.
 
   Original author: DESODBC Developer
 */
-SQLRETURN DBC::get_mutex(sem_t *s, const std::string &name) {
+static bool wait_semaphore(sem_t *s) {
   timeval tv_start;
   gettimeofday(&tv_start, nullptr);
 
-  bool success = false;
+  // macOS lacks sem_timedwait: we poll, backing off from 1 ms to 100 ms
+  useconds_t backoff = 1000;
 
-  while (!success) {
-    if (sem_trywait(s) == 0) {
-      success = true;
-    } else {
-      timeval tv_end;
-      gettimeofday(&tv_end, nullptr);
-      long secs = tv_end.tv_sec - tv_start.tv_sec;
-      if (secs >= MUTEX_TIMEOUT_SECONDS) {
-        std::string msg = "Fetching mutex ";
-        msg += std::string(name);
-        msg +=
-            " timed-out. Perhaps a connection was closed unsafely. In that "
-            "case, a manual removal of this mutex may be required (try ";
+  while (sem_trywait(s) != 0) {
+    timeval tv_end;
+    gettimeofday(&tv_end, nullptr);
+    if (tv_end.tv_sec - tv_start.tv_sec >= MUTEX_TIMEOUT_SECONDS) return false;
+    usleep(backoff);
+    backoff = std::min<useconds_t>(backoff * 2, 100000);
+  }
+  return true;
+}
+
+/* DESODBC:
+  This function gets a generic mutex
+  in Unix-like systems.
+
+  Original author: DESODBC Developer
+*/
+SQLRETURN DBC::get_mutex(sem_t *s, const std::string &name) {
+  if (!wait_semaphore(s)) {
+    std::string msg = "Fetching mutex ";
+    msg += std::string(name);
+    msg +=
+        " timed-out. Perhaps a connection was closed unsafely. In that "
+        "case, a manual removal of this mutex may be required (try ";
 
 #ifdef __APPLE__
-        msg +=
-            "with unlink (2). In macOS, mutexes do not exist in the "
-            "filesystem)";
+    msg +=
+        "with unlink (2). In macOS, mutexes do not exist in the "
+        "filesystem)";
 #else
-        msg += "removing the corresponding V shared memory segment with ipcrm)";
+    msg += "removing the corresponding V shared memory segment with ipcrm)";
 #endif
-        return this->set_unix_error(msg, false);
-      } else
-        usleep(100000);
-    }
+    return this->set_unix_error(msg, false);
   }
   return SQL_SUCCESS;
 }
@@ -789,6 +860,221 @@ SQLRETURN DBC::release_mutex(sem_t *s, const std::string &name) {
   }
   return SQL_SUCCESS;
 }
+
+#ifndef __APPLE__
+/* DESODBC:
+  This function tells whether the process with the given PID is gone. It
+  is async-signal-safe.
+
+  Original author: DESODBC Developer
+*/
+static bool process_is_gone(pid_t pid) {
+  return kill(pid, 0) == -1 && errno == ESRCH;
+}
+
+/* DESODBC:
+  The guard of a TicketMutex is only held for a few instructions, by the
+  process whose PID it holds. If that process is killed meanwhile, the
+  guard is taken from it: none of those instructions leaves the mutex
+  half updated.
+
+  Original author: DESODBC Developer
+*/
+static void lock_ticket_guard(TicketMutex *m) {
+  uint32_t self = (uint32_t)getpid();
+  unsigned int spins = 0;
+  uint32_t holder = 0;
+  while (!m->guard.compare_exchange_weak(holder, self,
+                                         std::memory_order_acquire)) {
+    if (holder != 0 && ++spins % 1024 == 0 && process_is_gone(holder))
+      m->guard.compare_exchange_strong(holder, 0, std::memory_order_relaxed);
+    holder = 0;
+    sched_yield();
+  }
+}
+
+static void unlock_ticket_guard(TicketMutex *m) {
+  m->guard.store(0, std::memory_order_release);
+}
+
+/* DESODBC:
+  This function serves the ticket after serving, skipping those of the
+  waiters that timed out, and wakes the waiters. It must be called with
+  the guard held, which it releases.
+
+  Original author: DESODBC Developer
+*/
+static void serve_next_ticket(TicketMutex *m, uint32_t serving) {
+  uint32_t next = serving + 1;
+  while (m->abandoned[next % TICKET_RING_SIZE] == (uint64_t)next + 1) {
+    m->abandoned[next % TICKET_RING_SIZE] = 0;
+    next++;
+  }
+  m->now_serving.store(next, std::memory_order_release);
+  unlock_ticket_guard(m);
+
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(&m->now_serving),
+          FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+/* DESODBC:
+  This function skips the ticket being served if the process that took
+  it is gone, whether it held the mutex or was still waiting for it. A
+  ticket whose process has not recorded its PID yet counts as gone once
+  unrecorded was already true in the previous check (MUTEX_OWNER_CHECK_MS
+  before), since a live process records it right after taking the ticket.
+
+  Original author: DESODBC Developer
+*/
+static void skip_gone_owner(TicketMutex *m, uint32_t serving,
+                            bool &unrecorded) {
+  uint64_t owner =
+      m->owners[serving % TICKET_RING_SIZE].load(std::memory_order_acquire);
+  uint32_t owner_ticket = (uint32_t)(owner >> 32);
+  bool gone;
+  if (owner != 0 && owner_ticket == serving) {
+    unrecorded = false;
+    gone = process_is_gone((pid_t)(uint32_t)owner);
+  } else if (owner == 0 || (int32_t)(owner_ticket - serving) < 0) {
+    gone = unrecorded;
+    unrecorded = true;
+  } else {
+    // A later ticket that shares its slot: we cannot tell
+    unrecorded = false;
+    gone = false;
+  }
+  if (!gone) return;
+
+  lock_ticket_guard(m);
+  if (m->now_serving.load(std::memory_order_relaxed) != serving) {
+    unlock_ticket_guard(m);
+    return;
+  }
+  unrecorded = false;
+  serve_next_ticket(m, serving);
+}
+
+/* DESODBC:
+  This function waits for a TicketMutex, sleeping until it is our turn
+  or MUTEX_TIMEOUT_SECONDS pass; in the latter case, it returns false.
+  Every MUTEX_OWNER_CHECK_MS without progress, it checks whether the
+  process of the ticket being served is gone (see skip_gone_owner). It
+  neither allocates memory nor records errors, so a forked child may call
+  it.
+
+  Original author: DESODBC Developer
+*/
+static bool wait_ticket(TicketMutex *m) {
+  uint32_t ticket = m->next_ticket.fetch_add(1, std::memory_order_relaxed);
+  m->owners[ticket % TICKET_RING_SIZE].store(
+      ((uint64_t)ticket << 32) | (uint32_t)getpid(),
+      std::memory_order_release);
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::seconds(MUTEX_TIMEOUT_SECONDS);
+  bool unrecorded = false;
+
+  while (true) {
+    uint32_t serving = m->now_serving.load(std::memory_order_acquire);
+    if (serving == ticket) return true;
+
+    long long left_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            deadline - std::chrono::steady_clock::now())
+                            .count();
+    if (left_ms <= 0) {
+      // Our ticket must be skipped, unless it has just been served
+      lock_ticket_guard(m);
+      bool served = m->now_serving.load(std::memory_order_acquire) == ticket;
+      if (!served)
+        m->abandoned[ticket % TICKET_RING_SIZE] = (uint64_t)ticket + 1;
+      unlock_ticket_guard(m);
+      return served;
+    }
+
+    // now_serving is shared between processes: no FUTEX_PRIVATE_FLAG
+    long long wait_ms = std::min<long long>(left_ms, MUTEX_OWNER_CHECK_MS);
+    timespec timeout;
+    timeout.tv_sec = wait_ms / 1000;
+    timeout.tv_nsec = (wait_ms % 1000) * 1000000;
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&m->now_serving),
+            FUTEX_WAIT, serving, &timeout, nullptr, 0);
+
+    if (m->now_serving.load(std::memory_order_acquire) == serving)
+      skip_gone_owner(m, serving, unrecorded);
+    else
+      unrecorded = false;
+  }
+}
+
+/* DESODBC:
+  This function initializes the mutexes of a shared memory segment once,
+  in the first process that attaches to it; the others wait until it is
+  done. Mutexes that may already be in use are never reset.
+
+  Original author: DESODBC Developer
+*/
+static bool init_ticket_mutexes(SharedMemoryUnix *shmem) {
+  uint32_t state = 0;
+  if (shmem->mutexes_state.compare_exchange_strong(state, 1,
+                                                   std::memory_order_acquire)) {
+    new (&shmem->shared_memory_mutex) TicketMutex();
+    new (&shmem->query_mutex) TicketMutex();
+    shmem->mutexes_state.store(2, std::memory_order_release);
+    return true;
+  }
+
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::seconds(MUTEX_TIMEOUT_SECONDS);
+  while (shmem->mutexes_state.load(std::memory_order_acquire) != 2) {
+    if (std::chrono::steady_clock::now() >= deadline) return false;
+    sched_yield();
+  }
+  return true;
+}
+
+/* DESODBC:
+  This function gets a TicketMutex (see wait_ticket).
+
+  Original author: DESODBC Developer
+*/
+SQLRETURN DBC::get_mutex(TicketMutex *m, const std::string &name) {
+  if (wait_ticket(m)) return SQL_SUCCESS;
+
+  std::string msg = "Fetching mutex ";
+  msg += std::string(name);
+  msg +=
+      " timed-out. Perhaps a connection was closed unsafely. In that "
+      "case, a manual removal of this mutex may be required (try "
+      "removing the corresponding V shared memory segment with ipcrm)";
+  return this->set_unix_error(msg, false);
+}
+
+/* DESODBC:
+  This function hands a TicketMutex to the next waiter that has not given
+  up. As wait_ticket, a forked child may call it.
+
+  Original author: DESODBC Developer
+*/
+static void pass_ticket(TicketMutex *m) {
+  lock_ticket_guard(m);
+  uint32_t serving = m->now_serving.load(std::memory_order_relaxed);
+  if (serving == m->next_ticket.load(std::memory_order_relaxed)) {
+    // Nobody holds it
+    unlock_ticket_guard(m);
+    return;
+  }
+  serve_next_ticket(m, serving);
+}
+
+/* DESODBC:
+  This function releases a TicketMutex (see pass_ticket).
+
+  Original author: DESODBC Developer
+*/
+SQLRETURN DBC::release_mutex(TicketMutex *m, const std::string &name) {
+  pass_ticket(m);
+  return SQL_SUCCESS;
+}
+#endif
 #endif
 
 #ifdef _WIN32
@@ -915,15 +1201,46 @@ SQLRETURN DBC::release_shared_memory_mutex() {
 #endif
 }
 
+#ifndef _WIN32
+/* DESODBC:
+  These functions get and release the shared memory mutex as the two
+  above, but they neither allocate memory nor record errors, so that a
+  forked child may call them (see DBC::start_linger_watchdog). The first
+  one returns false if it timed-out.
+
+  Original author: DESODBC Developer
+*/
+bool DBC::lock_shared_memory_mutex_in_child() {
+#ifdef __APPLE__
+  return wait_semaphore(this->shared_memory_mutex);
+#else
+  return wait_ticket(&this->shmem->shared_memory_mutex);
+#endif
+}
+
+void DBC::unlock_shared_memory_mutex_in_child() {
+#ifdef __APPLE__
+  sem_post(this->shared_memory_mutex);
+#else
+  pass_ticket(&this->shmem->shared_memory_mutex);
+#endif
+}
+#endif
+
 /* DESODBC:
   This function gets the query mutex.
 
   Original author: DESODBC Developer
 */
 SQLRETURN DBC::get_query_mutex() {
+  // A reply of this connection may still be keeping the mutex
+  SQLRETURN ret = this->finish_pending_reply();
+  if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) return ret;
+
 #ifdef _WIN32
   return get_mutex(this->query_mutex, QUERY_MUTEX_NAME);
 #else
+  if (this->use_broker) return this->get_broker_lock();
 #ifdef __APPLE__
   return get_mutex(this->query_mutex, QUERY_MUTEX_NAME);
 #else
@@ -941,6 +1258,7 @@ SQLRETURN DBC::release_query_mutex() {
 #ifdef _WIN32
   return release_mutex(this->query_mutex, QUERY_MUTEX_NAME);
 #else
+  if (this->use_broker) return this->release_broker_lock();
 #ifdef __APPLE__
   return release_mutex(this->query_mutex, QUERY_MUTEX_NAME);
 #else
@@ -949,6 +1267,24 @@ SQLRETURN DBC::release_query_mutex() {
 #endif
 }
 
+/* DESODBC:
+  This function tells whether other connections are waiting for the query
+  mutex that this one holds. Only ticket mutexes tell it; with the others,
+  it is taken for granted.
+
+  Original author: DESODBC Developer
+*/
+bool DBC::query_mutex_wanted() {
+#if defined(_WIN32) || defined(__APPLE__)
+  return true;
+#else
+  if (this->use_broker) return true;
+  TicketMutex *m = &this->shmem->query_mutex;
+  return m->next_ticket.load(std::memory_order_relaxed) -
+             m->now_serving.load(std::memory_order_relaxed) > 1;
+#endif
+}
+
 /* DESODBC:
   This function modifies the working directory removing
   the last '\' or '/' delimiter character if so.
@@ -1119,11 +1455,11 @@ SQLRETURN DBC::initialize() {
     return this->set_unix_error(msg, true);
   }
 #else
-  if (!this->shmem->des_process_created) {
-    if (sem_init(&this->shmem->shared_memory_mutex, 1, 1) == -1)
-      return this->set_unix_error("Failed to create shared memory mutex", true);
-    if (sem_init(&this->shmem->query_mutex, 1, 1) == -1)
-      return this->set_unix_error("Failed to create query mutex", true);
+  if (!init_ticket_mutexes(this->shmem)) {
+    return this->set_unix_error(
+        "Timed-out waiting for the mutexes of shared memory with key " +
+            std::to_string(this->connection_hash_int) + " to be ready",
+        false);
   }
 #endif
 
@@ -1153,6 +1489,7 @@ SQL_SUCCESS_WITH_INFO, a connection has been established.
 */
 SQLRETURN DBC::connect(DataSource *dsrc) {
   SQLRETURN rc = SQL_SUCCESS;
+  auto connect_start = std::chrono::steady_clock::now();
 
   this->cxn_charset_info = desodbc::get_charset(48, MYF(0));  // DESODBC: latin1
 
@@ -1178,7 +1515,36 @@ SQLRETURN DBC::connect(DataSource *dsrc) {
   const char *prepared_working_dir = prepare_working_dir(des_working_dir);
 #endif
 
-  this->get_concurrent_objects(des_exec_path, des_working_dir);
+  /* DESODBC:
+  Connections to the same working directory share a global DES process
+  or, with DES_POOL_SIZE > 1, a pool of them. Each process of a pool has
+  its own database and its own query mutex.
+  */
+#ifdef _WIN32
+  this->pool_key = std::to_string(wstr_hasher(std::wstring(des_working_dir)));
+#else
+  this->pool_key = std::to_string(str_hasher(std::string(des_working_dir)));
+#endif
+  this->acquire_pool_slot(dsrc->opt_DES_POOL_SIZE);
+  this->linger = dsrc->opt_DES_LINGER;
+  if (dsrc->opt_DES_SNAPSHOT)
+    this->snapshot_path = (const char *)dsrc->opt_DES_SNAPSHOT;
+
+  this->get_concurrent_objects(des_exec_path, des_working_dir,
+                               this->pool_slot);
+
+#ifndef _WIN32
+  /* DESODBC:
+  With DES_BROKER, DES belongs to a broker process (see broker.cc) instead
+  of to the connections, which need no shared memory nor named pipes.
+  */
+  if (dsrc->opt_DES_BROKER) {
+    this->use_broker = true;
+    rc = this->connect_broker(des_exec_path, prepared_working_dir);
+    this->connect_time_ms = elapsed_ms(connect_start);
+    return rc;
+  }
+#endif
 
   rc = this->initialize();
   if (rc != SQL_SUCCESS && rc != SQL_SUCCESS_WITH_INFO) return rc;
@@ -1205,9 +1571,12 @@ SQLRETURN DBC::connect(DataSource *dsrc) {
 #endif
     
 
+  bool launched = false;
   if (!this->shmem->des_process_created) {
+    launched = true;
     rc = this->createPipes();
     if (rc != SQL_SUCCESS && rc != SQL_SUCCESS_WITH_INFO) return rc;
+    auto launch_start = std::chrono::steady_clock::now();
 #ifdef _WIN32
     rc = this->create_DES_process(des_exec_path,
                                 &std::wstring(prepared_working_dir)[0]);
@@ -1217,6 +1586,7 @@ SQLRETURN DBC::connect(DataSource *dsrc) {
     if (rc != SQL_SUCCESS && rc != SQL_SUCCESS_WITH_INFO) return rc;
     shmem->n_clients = 1;
 #endif
+    this->launch_time_ms = elapsed_ms(launch_start);
 
     shmem->exec_hash_int = this->exec_hash_int;
   } else {
@@ -1227,6 +1597,20 @@ SQLRETURN DBC::connect(DataSource *dsrc) {
 #endif
   }
 
+  /*
+    The snapshot must be restored before any other client can query the
+    DES process we have just launched, so the query mutex is taken while
+    we still hold the shared memory one.
+  */
+  bool restoring = launched && !this->snapshot_path.empty();
+  if (restoring) {
+    rc = get_query_mutex();
+    if (rc != SQL_SUCCESS && rc != SQL_SUCCESS_WITH_INFO) {
+      release_shared_memory_mutex();
+      return rc;
+    }
+  }
+
 #ifdef _WIN32
   this->share_pipes_thread =
       std::unique_ptr<std::thread>(new std::thread(&DBC::sharePipes, this));
@@ -1250,7 +1634,72 @@ SQLRETURN DBC::connect(DataSource *dsrc) {
 
 #endif
   this->connected = true;
-  return SQL_SUCCESS;
+
+  rc = SQL_SUCCESS;
+  if (restoring) {
+    rc = this->restore_snapshot();
+    release_query_mutex();
+  }
+  this->connect_time_ms = elapsed_ms(connect_start);
+  return rc;
+}
+
+/* DESODBC:
+  This function restores the DES_SNAPSHOT file of the connection into
+  the DES process it has just launched. It must be called with the
+  query mutex held. A missing or unreadable snapshot does not make the
+  connection fail: DES keeps the state it started with and a warning
+  is returned instead.
+
+  Original author: DESODBC Developer
+*/
+SQLRETURN DBC::restore_snapshot() {
+  std::string file;
+  SQLRETURN rc;
+  if (quote_DES_path(this->snapshot_path, file)) {
+    auto pair = this->send_query_and_read("/restore_state " + file);
+    rc = pair.first;
+    if (rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO)
+      rc = check_and_set_errors(SQL_HANDLE_DBC, this, pair.second);
+    if (rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO) return rc;
+  } else
+    this->error.message = "the file name contains double quotes";
+
+  std::string msg = "Could not restore the DES snapshot " +
+                    this->snapshot_path + ": " + this->error.message;
+  this->set_error("01000", msg.c_str());
+  return SQL_SUCCESS_WITH_INFO;
+}
+
+/* DESODBC:
+  This function saves the current state of the DES process into a
+  snapshot file, so that later launches of DES can restore it with
+  DES_SNAPSHOT instead of replaying their start-up scripts. If path is
+  empty, the DES_SNAPSHOT file of the connection is used.
+
+  Original author: DESODBC Developer
+*/
+SQLRETURN DBC::save_snapshot(const std::string &path) {
+  std::string file = path.empty() ? this->snapshot_path : path;
+  if (file.empty())
+    return this->set_error("HY024",
+                           "No snapshot file given and DES_SNAPSHOT is not set");
+  if (!quote_DES_path(file, file))
+    return this->set_error("HY024",
+                           "Snapshot file names cannot contain double quotes");
+  if (!is_connected(this))
+    return this->set_error("08003", "Connection does not exist");
+
+  SQLRETURN rc = get_query_mutex();
+  if (rc != SQL_SUCCESS && rc != SQL_SUCCESS_WITH_INFO) return rc;
+
+  auto pair = this->send_query_and_read("/save_state force " + file);
+
+  release_query_mutex();
+
+  rc = pair.first;
+  if (rc != SQL_SUCCESS && rc != SQL_SUCCESS_WITH_INFO) return rc;
+  return check_and_set_errors(SQL_HANDLE_DBC, this, pair.second);
 }
 
 /* DESODBC:
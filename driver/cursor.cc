@@ -192,7 +192,7 @@ static my_bool have_field_in_result(const char *name, DES_RESULT *result) {
 */
 
 void set_current_cursor_data(STMT *stmt, SQLUINTEGER irow) {
-  long nrow, row_pos;
+  long row_pos;
   DES_RESULT *result = stmt->result;
 
   /*
@@ -203,16 +203,7 @@ void set_current_cursor_data(STMT *stmt, SQLUINTEGER irow) {
   row_pos = irow ? (long)(stmt->current_row + irow - 1) : stmt->current_row;
 
   if (stmt->cursor_row != row_pos) {
-    DES_ROWS *dcursor;
-    dcursor = result->data->data;
-
-    if (dcursor) {
-      for (nrow = 0; nrow < row_pos; ++nrow) {
-        dcursor = dcursor->next;
-      }
-    }
-
-    result->data_cursor = dcursor;
+    result->data_cursor = row_pos;
 
     stmt->cursor_row = row_pos;
   }
@@ -330,7 +321,8 @@ static bool insert_field_std(STMT *stmt, DES_RESULT *result, std::string &str,
   SQLLEN length;
   char as_string[50], *dummy;
 
-  row_data = result->data_cursor->data + nSrcCol;
+  row_data = result->data->cells +
+             result->data_cursor * result->data->fields + nSrcCol;
 
   /* Copy row buffer data to statement */
   iprec->concise_type = get_sql_data_type(stmt, field, 0);
@@ -1391,8 +1383,10 @@ static SQLRETURN execute_delete_algorithm(STMT *stmt, SQLUSMALLINT irow) {
   }
   insert_query += ")";
 
-  for (int i = 0; i < (num_duplicates - 1); ++i) {
-    auto pair = stmt->dbc->send_query_and_read(insert_query);
+  // The duplicates are inserted back as a pipelined batch
+  if (num_duplicates > 1) {
+    std::vector<std::string> insert_queries(num_duplicates - 1, insert_query);
+    auto pair = stmt->dbc->send_queries_and_read(insert_queries);
     if (!SQL_SUCCEEDED(pair.first)) return pair.first;
   }
   return ret;
@@ -1636,7 +1630,7 @@ SQLCHAR *MySQLGetCursorName(HSTMT hstmt) {
 SQLRETURN SQL_API SQLSetPos(SQLHSTMT hstmt, SQLSETPOSIROW irow,
                             SQLUSMALLINT fOption, SQLUSMALLINT fLock) {
   SQLRETURN rc = SQL_SUCCESS;
-  CHECK_HANDLE(hstmt);
+  CHECK_STMT_IDLE(hstmt);
   STMT *stmt = (STMT *)hstmt;
   try {
     rc = DES_SQLSetPos(hstmt, irow, fOption, fLock);
@@ -1654,6 +1648,7 @@ SQLRETURN SQL_API SQLSetPos(SQLHSTMT hstmt, SQLSETPOSIROW irow,
 */
 
 SQLRETURN SQL_API SQLBulkOperations(SQLHSTMT Handle, SQLSMALLINT Operation) {
+  CHECK_STMT_IDLE(Handle);
   STMT *stmt = (STMT *)Handle;
   SQLRETURN sqlRet = SQL_SUCCESS;
   DES_RESULT *result = stmt->result;
@@ -1714,7 +1709,7 @@ SQLRETURN SQL_API SQLBulkOperations(SQLHSTMT Handle, SQLSMALLINT Operation) {
 */
 
 SQLRETURN SQL_API SQLCloseCursor(SQLHSTMT Handle) {
-  CHECK_HANDLE(Handle);
+  CHECK_STMT_IDLE(Handle);
 
   return DES_SQLFreeStmt(Handle, SQL_CLOSE);
 }
@@ -75,22 +75,65 @@ typedef unsigned int class_id_t;
 using std::nullptr_t;
 
 //DESODBC: added some libraries
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <list>
 #include <mutex>
 #include <regex>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <variant>
 #include <vector>
 #include "error.h"
 #include "parse.h"
 
-#define MAX_OUTPUT_WAIT_MS 2000
+/* DESODBC:
+  Milliseconds that a newly launched DES has to answer the readiness
+  handshake (see DBC::wait_DES_ready) before it is terminated.
+*/
+#define DES_LAUNCH_TIMEOUT_MS 60000
 
 #define BUFFER_SIZE 4096
 
+/* DESODBC:
+  Commands of a pipelined batch (see DBC::send_queries_and_read) are
+  written in chunks of at most this many bytes, which the DES input pipe
+  always takes at once.
+*/
+#define PIPELINE_MAX_BYTES 4096
+
+/* DESODBC:
+  Receive buffers that grew beyond this size to fit an exceptionally large
+  reply are shrunk back once the reply has been consumed.
+*/
+#define RECV_BUFFER_KEEP_SIZE (4 * 1024 * 1024)
+
+/* DESODBC:
+  Number of rows that forward-only cursors without cache read from DES
+  at once (at least a rowset).
+*/
+#define STREAM_WINDOW_ROWS 1024
+
+/* DESODBC:
+  Milliseconds after which a forward-only cursor that is not fetched from
+  gives the query mutex up if others want it (see DESRowStream).
+*/
+#define STREAM_IDLE_TIMEOUT_MS 500
+
+/* DESODBC:
+  Size of the first block of the arena that holds the cells of a result
+  table. Further blocks grow as needed.
+*/
+#define RESULT_ARENA_BLOCK_SIZE 8192
+
 #define LOCK_STMT(S) \
   CHECK_HANDLE(S);   \
   std::unique_lock<std::recursive_mutex> slock(((STMT *)S)->lock)
@@ -100,6 +143,16 @@ using std::nullptr_t;
                                                std::defer_lock)
 #define DO_LOCK_STMT() slock.lock();
 
+/* DESODBC:
+  While the statement is executed asynchronously (see STMT::start_async),
+  and until its result is polled, its functions return HY010, except the
+  one that started it, SQLCancel, SQLFreeStmt and SQLFreeHandle.
+*/
+#define CHECK_STMT_IDLE(S)                 \
+  CHECK_HANDLE(S);                         \
+  if (((STMT *)S)->async_result.valid())   \
+    return ((STMT *)S)->set_error("HY010", "Function sequence error")
+
 #define LOCK_DBC(D) \
   std::unique_lock<std::recursive_mutex> dlock(((DBC *)D)->lock)
 #define LOCK_DBC_DEFER(D)                                        \
@@ -116,6 +169,15 @@ using std::nullptr_t;
 #define CB_FIDO_GLOBAL DES_DRIVER_CONNECT_ATTR_BASE + 0x00001000
 #define CB_FIDO_CONNECTION DES_DRIVER_CONNECT_ATTR_BASE + 0x00001001
 
+// DESODBC: saves the DES database to the DES_SNAPSHOT file of the
+// connection, or to the file given as value (a string)
+#define DES_ATTR_SAVE_SNAPSHOT DES_DRIVER_CONNECT_ATTR_BASE + 0x00002000
+// DESODBC: read-only, milliseconds (SQLUINTEGER) that the connection took
+// to be established and, out of them, that DES took to start up (0 if the
+// connection attached to a DES process that was already running)
+#define DES_ATTR_CONNECT_TIME DES_DRIVER_CONNECT_ATTR_BASE + 0x00002001
+#define DES_ATTR_LAUNCH_TIME DES_DRIVER_CONNECT_ATTR_BASE + 0x00002002
+
 #if defined(_WIN32) || defined(WIN32)
 #define INTFUNC __stdcall
 #define EXPFUNC __stdcall
@@ -335,6 +397,7 @@ extern std::mutex global_fido_mutex;
 #define SHARED_MEMORY_MUTEX_NAME_BASE "DESODBC_SHMEM_MUTEX"
 #define QUERY_MUTEX_NAME_BASE "DESODBC_QUERY_MUTEX"
 #define DES_MAX_STRLEN 255  // we are mimicring PostgreSQL's convention
+#define MAX_DES_POOL_SIZE 16  // DES processes per working directory
 #ifdef _WIN32
 #define REQUEST_HANDLE_EVENT_NAME_BASE "DESODBC_REQUEST_HANDLE_EVENT"
 #define REQUEST_HANDLE_MUTEX_NAME_BASE "DESODBC_REQUEST_HANDLE_MUTEX"
@@ -347,6 +410,21 @@ extern std::mutex global_fido_mutex;
 #define IN_WPIPE_NAME_BASE "/tmp/DESODBC_IN_WPIPE"
 #define OUT_RPIPE_NAME_BASE "/tmp/DESODBC_OUT_RPIPE"
 #define MUTEX_TIMEOUT_SECONDS 10
+#define TICKET_RING_SIZE 1024  // waiters of a TicketMutex that may give up
+#define MUTEX_OWNER_CHECK_MS 100  // how often waiters look for a dead holder
+
+/* DESODBC:
+  With DES_BROKER, connections reach DES through a broker process that
+  listens on a Unix domain socket (see broker.cc). Connections send it
+  the same framed /tapi lines they would write into the DES input pipe;
+  any other line is a request to the broker itself.
+*/
+#define BROKER_SOCKET_NAME_BASE "/tmp/DESODBC_BROKER"
+#define BROKER_LOCK_NAME_BASE "/tmp/DESODBC_BROKER_LOCK"
+#define BROKER_LOCK "LOCK"            // LOCK <begin marker> <end marker>
+#define BROKER_UNLOCK "UNLOCK"
+#define BROKER_INTERRUPT "INTERRUPT"  // SIGINT to DES, if running our lines
+#define BROKER_TERMINATE "TERMINATE"  // kill DES (and so the broker)
 #endif
 
 
@@ -671,13 +749,14 @@ struct STMT_OPTIONS {
   SQLUINTEGER cursor_type = 0;
   SQLUINTEGER simulateCursor = 0;
   SQLULEN max_length = 0, max_rows = 0;
-  SQLULEN query_timeout = -1;
+  SQLULEN query_timeout = 0;
   SQLUSMALLINT *rowStatusPtr_ex = nullptr; /* set by SQLExtendedFetch */
   bool retrieve_data = true;
   SQLUINTEGER bookmarks = 0;
   void *bookmark_ptr = nullptr;
   bool bookmark_insert = false;
   bool metadata_id = false;  //DESODBC: added by DESODBC
+  SQLULEN async_enable = SQL_ASYNC_ENABLE_OFF;  //DESODBC: added by DESODBC
 };
 
 #ifdef _WIN32
@@ -745,6 +824,27 @@ struct SharedMemoryWin {
 #include <iostream>
 #endif
 
+/* DESODBC:
+    Cross-process mutex that lives in the shared memory, where all zeros
+    is its unlocked state. Each waiter takes a ticket and sleeps on a futex
+    until its ticket is served, so the mutex is handed over in FIFO order
+    and the next waiter wakes as soon as it is released. The ticket being
+    served is skipped if the process that took it is gone, so a process
+    killed while it holds or waits for the mutex does not block the rest.
+    Original author: DESODBC Developer
+*/
+struct TicketMutex {
+  std::atomic<uint32_t> next_ticket;
+  std::atomic<uint32_t> now_serving;
+
+  // PID of the process that holds it (0 if free) while tickets are skipped
+  std::atomic<uint32_t> guard;
+  // Ticket + 1 of the waiters that timed out, by ticket
+  uint64_t abandoned[TICKET_RING_SIZE];
+  // Ticket << 32 | PID of the process that took it, by ticket
+  std::atomic<uint64_t> owners[TICKET_RING_SIZE];
+};
+
 /* DESODBC:
     Original author: DESODBC Developer
 */
@@ -753,9 +853,16 @@ struct SharedMemoryUnix {
   pid_t DES_pid = -1;
   bool des_process_created = false;
   int exec_hash_int = 0;
-
-  sem_t shared_memory_mutex;
-  sem_t query_mutex;
+  // Incremented every time the last client leaves DES lingering (see
+  // DBC::start_linger_watchdog)
+  unsigned int linger_generation = 0;
+
+  // Not used in macOS, which uses named semaphores. mutexes_state goes
+  // from 0 (a new segment) to 1 while the first process that attaches to
+  // it initializes the mutexes, and then to 2 (see init_ticket_mutexes)
+  std::atomic<uint32_t> mutexes_state;
+  TicketMutex shared_memory_mutex;
+  TicketMutex query_mutex;
 };
 
 #endif
@@ -801,6 +908,73 @@ enum COMMAND_TYPE {
 
 struct DES_RESULT;
 
+/* DESODBC:
+    Receives, line by line, the reply to a command while it is
+    being read from DES. Lines are given without their '\n'; newline
+    tells whether the line was terminated by one.
+    Original author: DESODBC Developer
+*/
+struct DESReplySink {
+  virtual ~DESReplySink() {}
+  virtual void on_line(std::string_view line, bool newline) = 0;
+  // When true after a line, reading stops there and the rest of the reply
+  // is left in the pipe until DBC::continue_DES_reply is called.
+  virtual bool paused() { return false; }
+};
+
+/* DESODBC:
+    Collects the reply to a command into a string, as it was printed.
+    Original author: DESODBC Developer
+*/
+struct DESReplyText : DESReplySink {
+  std::string &text;
+
+  DESReplyText(std::string &out) : text(out) {}
+
+  void on_line(std::string_view line, bool newline) override {
+    text.append(line.data(), line.size());
+    if (newline) text += '\n';
+  }
+};
+
+/* DESODBC:
+    Throws away the reply to a command.
+    Original author: DESODBC Developer
+*/
+struct DESReplyDiscard : DESReplySink {
+  void on_line(std::string_view, bool) override {}
+};
+
+struct DESRowStream;
+
+/* DESODBC:
+    Thread of a connection that runs the statement functions called
+    with SQL_ATTR_ASYNC_ENABLE on, one at a time and in the order they
+    were called. When a job is done, the notification callback given by
+    the driver manager (if any) is called.
+    Original author: DESODBC Developer
+*/
+struct AsyncWorker {
+  struct Job {
+    std::packaged_task<SQLRETURN()> task;
+    SQLPOINTER callback = nullptr;
+    SQLPOINTER context = nullptr;
+  };
+
+  std::mutex mutex;
+  std::condition_variable wakeup;
+  std::deque<Job> jobs;
+  bool stopping = false;
+  std::thread thread;
+
+  AsyncWorker();
+  // Runs the jobs still queued and joins the thread
+  ~AsyncWorker();
+
+  void submit(Job job);
+  void run();
+};
+
 /* DESODBC:
     Added new attributes to support IPC.
     Original author: MyODBC
@@ -824,6 +998,65 @@ struct DBC {
   std::string exec_hash = "";
   int exec_hash_int = 0;
 
+  // Pool of DES processes of the connection (the hash of its working
+  // directory) and the process of the pool it was routed to
+  std::string pool_key = "";
+  int pool_slot = -1;
+
+  // Seconds that DES is kept running once its last client disconnects
+  // (DES_LINGER)
+  int linger = 0;
+
+  // File from which a freshly launched DES restores its state
+  // (DES_SNAPSHOT)
+  std::string snapshot_path = "";
+
+  // Whether DES is reached through the DES broker (DES_BROKER), in which
+  // case both DES pipes are the socket connected to it
+  bool use_broker = false;
+
+  // Milliseconds that establishing the connection took and, out of them,
+  // that the DES process it launched took to be ready (0 if none)
+  SQLUINTEGER connect_time_ms = 0;
+  SQLUINTEGER launch_time_ms = 0;
+
+  // Sequence number of the last command sent, used to frame DES replies
+  unsigned long long reply_seq = 0;
+
+  // DES output is read straight into this buffer, reused across commands
+  std::vector<char> recv_buffer;
+  // Bytes of recv_buffer read from DES but not handed to a sink yet
+  size_t recv_used = 0;
+
+  // Reply being read. It stays pending while a sink has paused it.
+  std::string reply_begin_marker = "";
+  std::string reply_end_marker = "";
+  bool reply_started = false;
+  bool reply_pending = false;
+
+  // SELECT answer being fetched by a forward-only cursor (see DESRowStream)
+  DESRowStream *active_stream = nullptr;
+  // Reads the rest of a reply whose cursor was closed before its end
+  std::unique_ptr<std::thread> drain_thread;
+  // Runs the asynchronous executions of the statements (started on demand)
+  std::unique_ptr<AsyncWorker> async_worker;
+
+  // Statement whose query is being sent to DES and its reply read, the
+  // deadline of that reply (SQL_ATTR_QUERY_TIMEOUT) and whether SQLCancel
+  // was called on it (see DBC::abandon_DES_reply)
+  std::atomic<STMT *> executing_stmt{nullptr};
+  std::chrono::steady_clock::time_point reply_deadline =
+      std::chrono::steady_clock::time_point::max();
+  std::atomic<bool> cancel_requested{false};
+  // Set while the rest of an abandoned reply is skipped, and once it has
+  // been abandoned until the next command is sent
+  bool resyncing = false;
+  bool reply_abandoned = false;
+  // Set in the thread that discards the rest of a closed stream (see
+  // DESRowStream::close), whose errors are not recorded: the application
+  // may be reading the diagnostics of the connection meanwhile
+  static thread_local bool discarding_in_background;
+
 #ifdef _WIN32
   LPCSTR SHARED_MEMORY_NAME;
   LPCSTR SHARED_MEMORY_MUTEX_NAME;
@@ -859,9 +1092,11 @@ struct DBC {
   const char *QUERY_MUTEX_NAME;
   const char *IN_WPIPE_NAME;
   const char *OUT_RPIPE_NAME;
+  const char *BROKER_SOCKET_NAME;
+  const char *BROKER_LOCK_NAME;
 
   int shm_id;
-  SharedMemoryUnix *shmem;
+  SharedMemoryUnix *shmem = nullptr;
 
 #ifdef __APPLE__
   sem_t *shared_memory_mutex;
@@ -922,13 +1157,16 @@ struct DBC {
   #ifdef _WIN32
   LPCSTR build_name(const char *name_base);
   void get_concurrent_objects(const wchar_t *des_exec_path,
-                            const wchar_t *des_working_dir);
+                            const wchar_t *des_working_dir, int slot);
   #else
   const char *build_name(const char *name_base);
   void get_concurrent_objects(const char *des_exec_path,
-                            const char *des_working_dir);
+                            const char *des_working_dir, int slot);
   #endif
 
+  void acquire_pool_slot(int pool_size);
+  void release_pool_slot();
+
   SQLRETURN initialize();
 
   SQLRETURN createPipes();
@@ -943,6 +1181,7 @@ struct DBC {
   #endif
 
   SQLRETURN get_DES_process_pipes();
+  SQLRETURN wait_DES_ready();
 
   #ifdef _WIN32
   void sharePipes();
@@ -954,6 +1193,8 @@ struct DBC {
   #else
   SQLRETURN get_mutex(sem_t *s, const std::string &name);
   SQLRETURN release_mutex(sem_t *s, const std::string &name);
+  SQLRETURN get_mutex(TicketMutex *m, const std::string &name);
+  SQLRETURN release_mutex(TicketMutex *m, const std::string &name);
   #endif
 
   #ifdef _WIN32
@@ -969,9 +1210,14 @@ struct DBC {
 
   SQLRETURN get_shared_memory_mutex();
   SQLRETURN release_shared_memory_mutex();
+#ifndef _WIN32
+  bool lock_shared_memory_mutex_in_child();
+  void unlock_shared_memory_mutex_in_child();
+#endif
 
   SQLRETURN get_query_mutex();
   SQLRETURN release_query_mutex();
+  bool query_mutex_wanted();
 
   
   /*DESODBDC:
@@ -979,16 +1225,33 @@ struct DBC {
     Original author: DESODBC
   */
 
+  std::pair<std::string, std::string> next_reply_markers();
+  void reserve_recv_buffer(size_t used);
+
   #ifdef _WIN32
-  std::pair<SQLRETURN, std::string> read_DES_output_win(
-      const std::string &query);
+  SQLRETURN read_DES_output_win(size_t &used, int timeout_ms);
   #else
-  std::pair<SQLRETURN, std::string> read_DES_output_unix(
-      const std::string &query);
+  ssize_t drain_DES_output(size_t &used);
+  SQLRETURN read_DES_output_unix(size_t &used, int timeout_ms);
   #endif
 
+  SQLRETURN read_DES_reply(const std::string &begin_marker,
+                           const std::string &end_marker,
+                           DESReplySink &sink);
+  SQLRETURN continue_DES_reply(DESReplySink &sink);
+  bool reply_interrupted();
+  SQLRETURN abandon_DES_reply();
+  void discard_DES_reply();
+  void interrupt_DES();
+  void terminate_DES();
+  SQLRETURN finish_pending_reply();
+
+  SQLRETURN write_DES_input(const std::string &data);
+  SQLRETURN send_query_and_read(const std::string &query, DESReplySink &sink);
   std::pair<SQLRETURN, std::string> send_query_and_read(
       const std::string &query);
+  std::pair<SQLRETURN, std::vector<std::string>> send_queries_and_read(
+      const std::vector<std::string> &queries);
   std::pair<SQLRETURN, DES_RESULT *> send_query_and_get_results(
       COMMAND_TYPE type, const std::string &query);
   
@@ -1016,6 +1279,17 @@ struct DBC {
   SQLRETURN connect(DataSource *ds);
 
   SQLRETURN close();
+  SQLRETURN restore_snapshot();
+  SQLRETURN save_snapshot(const std::string &path);
+#ifndef _WIN32
+  bool start_linger_watchdog();
+  SQLRETURN connect_broker(const char *des_exec_path,
+                           const char *des_working_dir);
+  SQLRETURN launch_DES_broker(const char *des_exec_path,
+                              const char *des_working_dir, char &status);
+  SQLRETURN get_broker_lock();
+  SQLRETURN release_broker_lock();
+#endif
   ~DBC();
 
   void set_charset(std::string charset);
@@ -1027,6 +1301,19 @@ struct DBC {
 */
 inline std::list<DBC *> active_dbcs_global_var;
 
+/* DESODBC:
+    Quotes a file name as an argument of a DES command (such as
+    /restore_state), so that it may contain blanks. Used by both the
+    driver and the broker. A name with double quotes cannot be quoted
+    this way: it returns false.
+    Original author: DESODBC Developer
+*/
+inline bool quote_DES_path(const std::string &path, std::string &quoted) {
+  if (path.find('"') != std::string::npos) return false;
+  quoted = "\"" + path + "\"";
+  return true;
+}
+
 /* Statement states */
 
 enum DES_STATE { ST_UNKNOWN = 0, ST_PREPARED, ST_PRE_EXECUTED, ST_EXECUTED };
@@ -1156,23 +1443,15 @@ struct STMT;
 typedef char **DES_ROW; /* return data as array of strings */
 
 /* DESODBC:
-    Rename done.
-    Original author: MySQL
-    Modified by: DESODBC Developer
-*/
-typedef struct DES_ROWS {
-  struct DES_ROWS *next = nullptr; /* list of rows */
-  DES_ROW data = nullptr;
-  unsigned long length = 0;
-} DES_ROWS;
-
-/* DESODBC:
-    Rename done.
+    Rename done. Rows are no longer a linked list: the cells of every row
+    are stored one row after the other, so that the n-th row is just
+    cells + n * fields. Their lengths are laid out the same way.
     Original author: MySQL
     Modified by: DESODBC Developer
 */
 typedef struct DES_DATA {
-  DES_ROWS *data = nullptr;
+  char **cells = nullptr;           /* rows * fields cells */
+  unsigned long *lengths = nullptr; /* lengths of the cells */
   struct MEM_ROOT *alloc = nullptr;
   uint64_t rows = 0;
   unsigned int fields = 0;
@@ -1195,12 +1474,14 @@ struct DES_RESULT {
   uint64_t row_count;
   DES_FIELD *fields = nullptr;
   struct DES_DATA *data = nullptr;
-  DES_ROWS *data_cursor = nullptr;
-  unsigned long *lengths = nullptr; /* column lengths of current row */
+  uint64_t data_cursor = 0;         /* number of the next row to fetch */
+  unsigned long *lengths = nullptr; /* column lengths of current row,
+                                       into data or the stream */
   const struct DES_METHODS *methods = nullptr;
   DES_ROW row = nullptr;         /* If unbuffered read */
   DES_ROW current_row = nullptr; /* buffer to current row */
   ResultTable *internal_table = nullptr;
+  DESRowStream *stream = nullptr; /* rows still being read from DES */
   unsigned int field_count, current_field;
   bool eof; /* Used by mysql_fetch_row */
   /* mysql_stmt_close() had to cancel this result */
@@ -1216,18 +1497,25 @@ struct DES_RESULT {
 // Mimicring MySQL extern functions
 // (some of them, extracted from the MySQL Server's source code)
 
+//DESODBC: forward declaration due to call from des_fetch_row
+DES_ROW stream_fetch_row(DESRowStream *stream);
+
 /* DESODBC:
     Original author: MySQL
     Modified by: DESODBC Developer
 */
 inline static DES_ROW des_fetch_row(DES_RESULT *result) {
   DES_ROW tmp = nullptr;
-  if (!result->data_cursor) {
+  if (result->stream) {
+    result->current_row = stream_fetch_row(result->stream);
+    return result->current_row;
+  }
+  if (!result->data || result->data_cursor >= result->data->rows) {
     result->current_row = tmp;
     return tmp;
   }
-  tmp = result->data_cursor->data;
-  result->data_cursor = result->data_cursor->next;
+  tmp = result->data->cells + result->data_cursor * result->data->fields;
+  result->data_cursor++;
   result->current_row = tmp;
 
   return tmp;
@@ -1262,12 +1550,8 @@ inline static uint64_t des_num_rows(DES_RESULT *res) { return res->row_count; }
     Modified by: DESODBC Developer
 */
 inline static void des_data_seek(DES_RESULT *result, uint64_t offset) {
-  DES_ROWS *tmp = nullptr;
-  if (result->data)
-    for (tmp = result->data->data; offset-- && tmp; tmp = tmp->next)
-      ;
   result->current_row = nullptr;
-  result->data_cursor = tmp;
+  result->data_cursor = offset;
 }
 
 /* DESODBC:
@@ -1275,7 +1559,7 @@ inline static void des_data_seek(DES_RESULT *result, uint64_t offset) {
     Original author: MySQL
     Modified by: DESODBC Developer
 */
-typedef DES_ROWS *DES_ROW_OFFSET; /* offset to current row */
+typedef uint64_t DES_ROW_OFFSET; /* number of the current row */
 
 /* DESODBC:
     Original author: MySQL
@@ -1510,8 +1794,30 @@ class charPtrBuf {
     Original author: DESODBC Developer
 */
 struct Column {
-  DES_FIELD *field;
+  DES_FIELD *field = nullptr;
+
+  // Cells of the column, by row. Their bytes live in the arena of the
+  // table they belong to; nullptr stands for NULL.
   std::vector<char *> values;
+  // Length of each cell, without its terminating '\0'
+  std::vector<unsigned long> lengths;
+
+  // Statistics of the values, kept as they are inserted or updated so that
+  // the metadata of the field does not need a pass over the cells. They
+  // are not lowered when rows are removed.
+  unsigned long max_value_length = 0;
+  unsigned int max_decimals = 0;
+
+  // Native copy of the cells of numeric and temporal columns, decoded once
+  // in batches as rows are indexed (see decode_rows), so that fetching them
+  // as a matching C type needs no parsing. Only the vector of the kind of the
+  // column is filled. Cells whose bit in decoded is not set (NULLs and
+  // text that does not decode cleanly) are converted from their text.
+  enum TypedKind { TYPED_NONE, TYPED_INT, TYPED_DOUBLE, TYPED_TIMESTAMP };
+  std::vector<long long> int_values;
+  std::vector<double> double_values;
+  std::vector<SQL_TIMESTAMP_STRUCT> ts_values;
+  std::vector<bool> decoded;
 
   bool new_heap_used = false;
 
@@ -1529,15 +1835,28 @@ struct Column {
   unsigned long getLength(int row);
   unsigned int getColumnSize();
   unsigned int getMaxLength();
-  DES_ROWS *generate_DES_ROWS(int current_row);
   DES_FIELD *get_DES_FIELD();
   Column(const std::string &table_name, const std::string &col_name,
          const TypeAndLength &col_type, const SQLSMALLINT &col_nullable);
-  void update_row(const int row_index, char *value);
+  void update_row(const int row_index, char *value, unsigned long length);
   void remove_row(const int row_index);
   SQLSMALLINT get_decimal_digits();
 
-  void insert_value(char *value) { values.push_back(value); }
+  void account_value(const char *value, unsigned long length);
+
+  TypedKind typed_kind() const;
+  void decode_value(size_t row);
+  void decode_rows(size_t first);
+  void erase_typed_rows(size_t first, size_t last);
+  bool is_decoded(size_t row) const {
+    return row < decoded.size() && decoded[row];
+  }
+
+  void insert_value(char *value, unsigned long length) {
+    values.push_back(value);
+    lengths.push_back(length);
+    account_value(value, length);
+  }
   std::string get_value(int index) const { return values[index - 1]; }
 
 };
@@ -1649,6 +1968,114 @@ struct STMT_params_for_table {
   bool metadata_id = false;
 };
 
+/* DESODBC:
+    Builds the ResultTable of a SELECT while its TAPI answer is being read,
+    instead of waiting for the whole output to split it into lines:
+    answer, then a name and a type line per column, $, and the values of
+    each row separated by $ until $eot.
+    Original author: DESODBC Developer
+*/
+struct TapiSelectParser : DESReplySink {
+  enum State {
+    EXPECT_ANSWER,
+    EXPECT_FIRST_COLUMN,
+    EXPECT_COLUMN_TYPE,
+    EXPECT_COLUMN,
+    EXPECT_ROW,
+    EXPECT_VALUE,
+    EXPECT_ROW_END,
+    FINISHED,
+    NOT_SELECT
+  };
+
+  ResultTable *table;
+  State state = EXPECT_ANSWER;
+  size_t n_lines = 0;
+
+  // If not 0, reading pauses once the table holds this many rows
+  size_t window_rows = 0;
+
+  std::string pending_column = "";
+  size_t n_columns = 0;
+  size_t current_col = 0;
+
+  // Whole output, only kept when it is not a SELECT answer
+  std::string raw = "";
+  // Whatever DES printed after $eot
+  std::string trailing = "";
+  // Non-answer outputs whose second line is $ have no table at all
+  bool second_line_is_dollar = false;
+
+  TapiSelectParser(ResultTable *t) : table(t) {}
+
+  void on_line(std::string_view line, bool newline) override;
+  void feed(const std::string &output);
+  void finish();
+  bool is_select() { return state != NOT_SELECT; }
+  bool paused() override;
+};
+
+/* DESODBC:
+    The answer to a SELECT executed by a forward-only cursor without cache
+    (see if_forward_cache). Instead of reading the whole answer on execution,
+    its rows are read from DES as they are fetched, so that the table only
+    holds a window of them. While the answer has not been completely read,
+    DES cannot take other commands, so the stream keeps the query mutex.
+    In Unix, if the cursor is not fetched from for STREAM_IDLE_TIMEOUT_MS
+    and other connections want the mutex, a thread reads the rest of the
+    answer into memory and releases it (see watch_idle). In Windows, only
+    the thread that owns the mutex can release it.
+    Original author: DESODBC Developer
+*/
+struct DESRowStream {
+  DBC *dbc;
+  ResultTable *table;
+  TapiSelectParser parser;
+
+  uint64_t first_row = 0;      // number of the first row held by table
+  uint64_t next_row = 0;       // number of the next row to be fetched
+
+  // Row index of the rows held by table (see DES_DATA), which were
+  // index_rows from first_row on when it was built
+  std::vector<char *> cells;
+  std::vector<unsigned long> lengths;
+  size_t index_rows = 0;
+  uint64_t index_first = 0;
+  bool pending = false;        // the answer has not been completely read
+  bool holds_query_mutex = false;
+  STMT *stmt = nullptr;        // statement whose query is answered
+
+  // Rest of the answer, read from DES on behalf of an idle cursor, the
+  // position up to which the parser has taken it and the result of reading
+  // it. Guarded by lock, as are the reads from DES, while idle_watch runs.
+  bool spilled = false;
+  std::string spill;
+  size_t spill_pos = 0;
+  SQLRETURN spill_ret = SQL_SUCCESS;
+
+  std::mutex lock;
+  std::condition_variable wake;
+  bool stop_watching = false;
+  std::chrono::steady_clock::time_point last_read;
+  std::unique_ptr<std::thread> idle_watch;
+
+  DESRowStream(DBC *d, ResultTable *t) : dbc(d), table(t), parser(t) {}
+  ~DESRowStream() { stop_idle_watch(); }
+
+  SQLRETURN continue_reply(DESReplySink &sink);
+  SQLRETURN continue_parsing();
+  bool reply_left();
+  SQLRETURN read_rows(size_t wanted);
+  SQLRETURN read_all();
+  SQLRETURN read_all_locked();
+  DES_ROW fetch_row();
+  void close();
+
+  void start_idle_watch();
+  void stop_idle_watch();
+  void watch_idle();
+};
+
 /* DESODBC:
     Original author: DESODBC Developer
 */
@@ -1665,14 +2092,23 @@ struct ResultTable {  // Internal representation of a result view.
   // Vector of column names, ordered by insertion time.
   std::vector<std::string> names_ordered;
 
-  // Some calls are given to the driver using only the
-  // column name. We need therefore to search the column given its name.
-  std::unordered_map<std::string, Column> columns;
+  // Columns, in the same order as their names.
+  std::vector<Column> columns;
+
+  // Bytes of every cell of the table, freed all at once with it.
+  desodbc::MEM_ROOT arena{PSI_NOT_INSTRUMENTED, RESULT_ARENA_BLOCK_SIZE};
+
+  // Row index last written by fill_row_index, to find the row of a
+  // DES_ROW handed out by a fetch (see cell_row)
+  char **indexed_cells = nullptr;
+  size_t indexed_rows = 0;
 
   ResultTable() {}
   ResultTable(STMT *stmt);
   ResultTable(COMMAND_TYPE type, const std::string &output);
 
+  void set_params(STMT *stmt);
+
   size_t col_count();
   size_t row_count();
 
@@ -1682,17 +2118,23 @@ struct ResultTable {  // Internal representation of a result view.
   void insert_col(DES_FIELD *field);
   void insert_cols(DES_FIELD array[], int array_size);
 
+  size_t col_index(const std::string &columnName);
+  Column &column(const std::string &columnName);
+
+  char *store_value(const char *value, size_t length);
+  void insert_value(size_t col, const char *value, size_t length);
   void insert_value(const std::string &columnName, char *value);
   void insert_value(const std::string &columnName, const std::string &value);
 
-  unsigned long *fetch_lengths(int current_row);
-  DES_ROW generate_DES_ROW(const int index);
-  DES_ROWS *generate_DES_ROWS(const int current_row);
+  void remove_first_rows(size_t n);
+  void fill_row_index(char **cells, unsigned long *lengths);
+  bool cell_row(DES_ROW row_cells, size_t &row);
+  void generate_row_index(DES_DATA *data);
   DES_FIELD *get_DES_FIELD(int col_index);
 
   std::vector<ForeignKeyInfo> get_foreign_keys_from_TAPI(
-      const std::vector<std::string> &lines, int &index);
-  DBSchemaRelationInfo get_relation_info(const std::vector<std::string> &lines,
+      const std::vector<std::string_view> &lines, int &index);
+  DBSchemaRelationInfo get_relation_info(const std::vector<std::string_view> &lines,
                                        int &index);
   std::unordered_map<std::string, DBSchemaRelationInfo> get_all_relations_info(
       const std::string &str);
@@ -1749,11 +2191,26 @@ struct STMT {
 
   std::string last_output = ""; //DESODBC: New attribute
 
+  // DESODBC: New attribute. Table already built while reading the output.
+  ResultTable *streamed_table = nullptr;
+  // DESODBC: New attribute. Set when the rest of the rows are still in DES.
+  DESRowStream *row_stream = nullptr;
+
   STMT_params_for_table params_for_table; //DESODBC: New attribute
 
   // DESODBC: New attribute
   COMMAND_TYPE type = UNKNOWN;  // unknown by default
 
+  // DESODBC: New attributes. Asynchronous execution in progress (see
+  // AsyncWorker): the ODBC function that started it and its result.
+  SQLUSMALLINT async_function = 0;
+  std::future<SQLRETURN> async_result;
+  std::atomic<bool> async_cancel{false};
+  // DESODBC: New attributes. Set by the driver manager for ODBC 3.8
+  // notification mode.
+  SQLPOINTER async_callback = nullptr;
+  SQLPOINTER async_context = nullptr;
+
   // DESODBC: New attribute
   bool new_row_des = true;
 
@@ -1826,6 +2283,22 @@ struct STMT {
   */
   SQLRETURN build_results();
 
+  /* DESODBC:
+    Original author: DESODBC
+  */
+  SQLRETURN start_async(SQLUSMALLINT function,
+                        std::function<SQLRETURN()> work);
+
+  /* DESODBC:
+    Original author: DESODBC
+  */
+  SQLRETURN poll_async(SQLUSMALLINT function);
+
+  /* DESODBC:
+    Original author: DESODBC
+  */
+  void finish_async();
+
 
   char *extend_buffer(char *to, size_t len);
   char *extend_buffer(size_t len);
@@ -1886,7 +2359,7 @@ struct STMT {
         result_array(),
         current_values(NULL),
         fields(NULL),
-        end_of_set(NULL),
+        end_of_set(0),
         tempbuf(),
         stmt_options(dbc->stmt_options),
         lengths(nullptr),
@@ -1958,10 +2431,30 @@ inline static uint64_t des_affected_rows(STMT *stmt) {
     Modified by: DESODBC Developer
 */
 inline static unsigned long *des_fetch_lengths(STMT *stmt) {
-  delete stmt->result->lengths;
-  stmt->result->lengths =
-      stmt->result->internal_table->fetch_lengths(stmt->current_row);
-  return stmt->result->lengths;
+  DES_RESULT *res = stmt->result;
+
+  // The lengths of the last fetched row are where its cells are
+  if (!res->current_row)
+    res->lengths = nullptr;
+  else if (res->stream)
+    res->lengths = res->stream->lengths.data() +
+                   (res->current_row - res->stream->cells.data());
+  else
+    res->lengths = res->data->lengths + (res->current_row - res->data->cells);
+
+  return res->lengths;
+}
+
+/* DESODBC:
+    Makes a streamed result hold at least the given number of rows after
+    the last fetched one, as long as DES has them.
+    Original author: DESODBC Developer
+*/
+inline static SQLRETURN des_read_stream(DES_RESULT *result, size_t wanted) {
+  SQLRETURN ret = result->stream->read_rows(wanted);
+  result->row_count =
+      result->stream->first_row + result->internal_table->row_count();
+  return ret;
 }
 
 //DESODBC: forward declaration due to call from des_store_result
@@ -2003,12 +2496,13 @@ inline static DES_RESULT *des_store_result(STMT *stmt) {
   data->rows = res->row_count;
   data->fields = res->field_count;
 
-  data->data = res->internal_table->generate_DES_ROWS(0);
+  // A stream indexes its rows as they are read
+  if (!res->stream) res->internal_table->generate_row_index(data);
 
   res->data = data;
-  res->data_cursor = res->data->data;
+  res->data_cursor = 0;
 
-  res->lengths = res->internal_table->fetch_lengths(0);
+  res->lengths = nullptr;
 
   res->current_row = nullptr;
   res->row = nullptr;
@@ -2083,35 +2577,6 @@ inline static char **copy(char **old, int size) {
   return cpy;
 }
 
-/* DESODBC:
-    Original author: DESODBC Developer
-*/
-inline static DES_ROWS *copy(DES_ROWS *old, int n_fields) {
-  if (!old) return nullptr;
-  DES_ROWS *cpy = new DES_ROWS;
-  cpy->length = old->length;
-  cpy->data = copy(old->data, n_fields);
-  if (!old->next)
-    cpy->next = nullptr;
-  else {
-    cpy->next = copy(old->next, n_fields);
-  }
-  return cpy;
-}
-
-/* DESODBC:
-    Original author: DESODBC Developer
-*/
-inline static DES_DATA *copy(DES_DATA *old) {
-  if (!old) return nullptr;
-  DES_DATA *cpy = new DES_DATA;
-  cpy->rows = old->rows;
-  cpy->fields = old->fields;
-  cpy->data = copy(old->data, old->fields);
-
-  return cpy;
-}
-
 /* DESODBC:
     Original author: DESODBC Developer
 */
@@ -2132,13 +2597,11 @@ inline static ResultTable *copy(ResultTable *old) {
   cpy->columns = old->columns;
 
   // Making the undone deep copies
-  for (auto pair : cpy->columns) {
-    Column col = pair.second;
+  for (Column &col : cpy->columns) {
     col.field = copy(col.field);
-    for (int i = 0; i < col.values.size(); ++i) {
-      char *old_ptr = col.values[i];
-      col.values[i] = new char;
-      memcpy(col.values[i], old_ptr, strlen(old_ptr));
+    for (size_t i = 0; i < col.values.size(); ++i) {
+      if (col.values[i])
+        col.values[i] = cpy->store_value(col.values[i], col.lengths[i]);
     }
   }
 
@@ -2160,24 +2623,22 @@ inline static DES_RESULT *copy(DES_RESULT *old) {
     DES_FIELD *new_field = cpy->fields + i;
     memcpy(new_field, old_field);
   }
-  cpy->data = copy(old->data);
-  cpy->data_cursor =
-      cpy->data->data;  // When copying the result table, we are resetting the
-                        // cursor. TODO: check if appropriate
-
-  cpy->lengths =
-      (unsigned long *)malloc(sizeof(unsigned long) * cpy->field_count);
+  cpy->internal_table = copy(old->internal_table);
 
-  for (int i = 0; i < cpy->field_count; ++i) {
-    unsigned long *old_length = old->lengths + i;
-    unsigned long *new_length = cpy->lengths + i;
-    *new_length = *old_length;
+  // The rows of the copy point to the cells of its own table
+  if (old->data) {
+    cpy->data = new DES_DATA;
+    cpy->data->rows = old->data->rows;
+    cpy->data->fields = old->data->fields;
+    cpy->internal_table->generate_row_index(cpy->data);
   }
+  cpy->data_cursor = 0;  // When copying the result table, we are resetting the
+                         // cursor. TODO: check if appropriate
 
-  cpy->row = copy(old->row, cpy->field_count);
-  cpy->current_row = copy(old->current_row, cpy->field_count);
+  cpy->lengths = nullptr;
 
-  cpy->internal_table = copy(old->internal_table);
+  cpy->row = copy(old->row, cpy->field_count);
+  cpy->current_row = nullptr;
 
   return cpy;
 }
@@ -2187,8 +2648,7 @@ static inline void free_result(ResultTable *table) {
         ResultTable itself does not have attributes in heap (except
         DBC, but we must not delete it), but Column does.
     */
-  for (int i = 0; i < table->names_ordered.size(); ++i) {
-      Column col = table->columns[table->names_ordered[i]];
+  for (Column &col : table->columns) {
     if (col.field && col.new_heap_used) {
       delete col.field->name;
       col.field->name = nullptr;
@@ -2203,12 +2663,10 @@ static inline void free_result(ResultTable *table) {
       col.field->org_table = nullptr;
     }
     delete col.field;
-    for (int j = 0; j < col.values.size(); ++j) {
-    delete col.values[j];
-    col.values[j] = nullptr;
-    }
+    col.field = nullptr;
   }
 
+  // The cells go away with the arena
   delete table;
   
 }
@@ -2224,37 +2682,38 @@ static inline void free_result(char** ptr, int size) {
   delete ptr;
 }
 
-inline static void free_result(DES_ROWS *rows, int n_fields) {
-  if (!rows) return;
-  free_result(rows->data, rows->length);
-  if (rows->next){
-    free_result(rows->next, n_fields);
-  }
-  delete rows;
-}
 static inline void free_result(DES_DATA *data) {
   if (!data) return;
-  free_result(data->data, data->fields);
+  // The cells themselves belong to the internal table
+  delete[] data->cells;
+  delete[] data->lengths;
 
   delete data;
 }
 
+//DESODBC: forward declaration due to call from free_result
+void close_row_stream(DESRowStream *stream);
+
 static inline void free_result(DES_RESULT *result) {
   if (!result) return;
 
+  if (result->stream) {
+    close_row_stream(result->stream);
+    result->stream = nullptr;
+  }
+
   delete[] result->fields;
   result->fields = nullptr;
 
   free_result(result->data);
   result->data = nullptr;
 
-  delete result->lengths;
   result->lengths = nullptr;
 
   free_result(result->row, result->field_count);
   result->row = nullptr;
 
-  free_result(result->current_row, result->field_count);
+  // The current row is one of the rows of data or of the stream
   result->current_row = nullptr;
 
   free_result(result->internal_table);
@@ -110,11 +110,17 @@ SQLRETURN ENV::set_error(const char *state, const char *msg) {
   return error.retcode;
 }
 
+/* DESODBC:
+    Original author: DESODBC Developer
+*/
+thread_local bool DBC::discarding_in_background = false;
+
 /* DESODBC:
     Original author: MyODBC
     Modified by: DESODBC Developer
 */
 SQLRETURN DBC::set_error(const char *state, const char *msg) {
+  if (discarding_in_background) return DESERROR(state, msg).retcode;
   error = DESERROR(state, msg);
   return error.retcode;
 }
@@ -44,233 +44,845 @@
 #include "driver.h"
 
 const long long TIMEOUT = 1000;
+// How often a read of a reply checks whether SQLCancel was called
+const int REPLY_POLL_MS = 100;
+// How long DES may take to get back to its prompt once interrupted
+const int RESYNC_TIMEOUT_MS = 5000;
 
-char buffer[BUFFER_SIZE];
-DWORD bytes_read = 0;
+/* DESODBC:
+  Every command is sent to DES between two /writeln commands that echo
+  markers unique to this connection and command. The reply is whatever DES
+  prints in between, so reading stops as soon as the reply is complete, no
+  matter its size or how long DES takes to compute it. Anything printed before
+  the opening marker (e.g., the remains of the DES startup messages) is
+  discarded.
+
+  Original author: DESODBC Developer
+*/
+std::pair<std::string, std::string> DBC::next_reply_markers() {
+  std::string marker = "DESODBC_" + std::to_string(this->connection_id) +
+                       "_" + std::to_string(++this->reply_seq);
+  return {marker + "_BEGIN", marker + "_END"};
+}
 
 /* DESODBC:
-  This function checks, given the output we have just read,
-  whether we should stop or try to read more output.
+  This function makes sure the receive buffer of the connection has room
+  for at least BUFFER_SIZE more bytes after the first used ones. The buffer
+  is kept between commands, so it only grows until it fits the usual reads.
 
   Original author: DESODBC Developer
 */
-bool check_stop(const std::string &query, const std::string &tapi_output) {
-  /*
-    Note: doing something like "if bytes_read < BUFFER_SIZE - 1  --> true" when
-    not calling /process, is not problematic. The read pipe ensure reading while
-    there are no sensible time gaps between the printing characteres. For
-    instance, executing /ls may have a enormous output; however, it will read it
-    at once since there will not be any "pauses". However, /process is an
-    exception to this rule. In between some parts of the output, it can wait the
-    enough time necessary so that the pipe thinks that the output is already
-    fetched. Fortunately, the /process output ensures a sentinel: that of "Info:
-    Batch file processed.", "Unknown command or incorrect number of arguments.",
-    "When processing file". Note: "$eot" is not a valid sentinel: it appears at
-    the end when there was an error, but it appears early at the beginning when
-    the command is correct, before all the processing.
-
-    In /dbschema occurs the same when the ODBC application is DES itself,
-    and connects to a DES process which connects to an external database.
-  */
+void DBC::reserve_recv_buffer(size_t used) {
+  if (this->recv_buffer.size() - used < BUFFER_SIZE)
+    this->recv_buffer.resize(
+        std::max(2 * this->recv_buffer.size(), used + BUFFER_SIZE));
+}
 
-  bool is_process = is_in_string(query, "/process");
-  bool is_dbschema = is_in_string(query, "/dbschema");
+/* DESODBC:
+  This function tells whether line ends with marker, ignoring a
+  trailing CR.
 
-  if (!is_process && !is_dbschema && bytes_read < BUFFER_SIZE - 1) {
-    return true;
-  }
+  Original author: DESODBC Developer
+*/
+static bool line_ends_with_marker(std::string_view line,
+                                  const std::string &marker,
+                                  size_t &marker_pos) {
+  if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+  if (line.size() < marker.size()) return false;
+  marker_pos = line.size() - marker.size();
+  return line.compare(marker_pos, marker.size(), marker) == 0;
+}
+
+#ifdef _WIN32
+/* DESODBC:
+  This function reads the next chunk of DES output into the receive buffer,
+  after its first used bytes, and advances used accordingly. ReadFile blocks
+  until DES writes something and returns all the available bytes that fit.
+  With a timeout (not negative), we first wait for DES output with
+  PeekNamedPipe and return SQL_NO_DATA if there is none in time.
 
-  if (is_process) {
-    // The following messages will be fetched completely, as there are not
-    // sufficient delay between reading each of these characters (the pipe reads
-    // them at once)
-    if (is_in_string(tapi_output, "Info: Batch file processed.")) return true;
-    if (is_in_string(tapi_output,
-                     "Unknown command or incorrect number of arguments."))
-      return true;
-    if (is_in_string(tapi_output, "When processing file")) return true;
-    /* We do not consider a default case. $eot is not a sentinel for some
-     * commands: in some commands it doesn't appear, and in some others the
-     * input doesn't end with $eot (check /ls). There are even some commands
-     * that do not have a sentinel (i.e. /write $computation_time$).*/
+  Original author: DESODBC Developer
+*/
+SQLRETURN DBC::read_DES_output_win(size_t &used, int timeout_ms) {
+  this->reserve_recv_buffer(used);
+
+  if (timeout_ms >= 0) {
+    auto end = std::chrono::steady_clock::now() +
+               std::chrono::milliseconds(timeout_ms);
+    DWORD available = 0;
+    while (true) {
+      if (!PeekNamedPipe(this->driver_to_des_out_rpipe, NULL, 0, NULL,
+                         &available, NULL))
+        return this->set_win_error("Failed to peek DES output", true);
+      if (available > 0) break;
+      if (std::chrono::steady_clock::now() >= end) return SQL_NO_DATA;
+      Sleep(1);
+    }
   }
 
-  if (is_dbschema) {
-    if (is_in_string(tapi_output, "$eot")) return true;
+  DWORD bytes_read = 0;
+  if (!ReadFile(this->driver_to_des_out_rpipe, this->recv_buffer.data() + used,
+                (DWORD)(this->recv_buffer.size() - used), &bytes_read, NULL)) {
+    return this->set_win_error("Failed to read DES output", true);
   }
+  if (bytes_read == 0) {
+    return this->set_win_error("DES closed its output pipe", false);
+  }
+  used += bytes_read;
 
-  return false;
+  return SQL_SUCCESS;
 }
+#else
+/* DESODBC:
+  This function blocks until the given pipe has data to be read, has been
+  hung up or timeout_ms milliseconds have elapsed (a negative timeout waits
+  forever). It returns a positive number in the first two cases, 0 on
+  timeout and -1 on error.
 
-#ifdef _WIN32
-DWORD WINAPI read_process(LPVOID lpParam) {
-  HANDLE read_pipe = (HANDLE)lpParam;
-
-  if (!ReadFile(read_pipe, buffer, sizeof(buffer) - sizeof(char), &bytes_read,
-                NULL)) {
-    DWORD err = GetLastError();
-    if (err == ERROR_OPERATION_ABORTED) {
-      return 0;  // forced abortion
+  Original author: DESODBC Developer
+*/
+int wait_for_pipe_input(int fd, int timeout_ms) {
+  struct pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+
+  int ret = poll(&pfd, 1, timeout_ms);
+  while (ret == -1 && errno == EINTR) ret = poll(&pfd, 1, timeout_ms);
+
+  return ret;
+}
+
+/* DESODBC:
+  This function reads everything that is available right now in the DES
+  output pipe straight into the receive buffer, after its first used bytes,
+  and advances used accordingly. It returns the number of bytes read, which
+  is 0 when the pipe was empty or hung up, or -1 on error.
+
+  Original author: DESODBC Developer
+*/
+ssize_t DBC::drain_DES_output(size_t &used) {
+  ssize_t total = 0;
+
+  while (true) {
+    this->reserve_recv_buffer(used);
+
+    ssize_t n = read(this->driver_to_des_out_rpipe,
+                     this->recv_buffer.data() + used,
+                     this->recv_buffer.size() - used);
+    if (n > 0) {
+      used += n;
+      total += n;
+    } else if (n == 0) {  // no writers left
+      break;
+    } else if (errno == EINTR) {
+      continue;
+    } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      break;
     } else {
-      return -1;  // real error
+      return -1;
     }
   }
 
-  buffer[bytes_read] = '\0';
-  return 0;  // success
+  return total;
+}
+
+/* DESODBC:
+  This function reads the next chunk of DES output into the receive buffer,
+  after its first used bytes, and advances used accordingly. When there is
+  nothing to read yet, we block on poll() until DES writes something, or
+  return SQL_NO_DATA after timeout_ms milliseconds (negative to wait
+  forever).
+
+  Original author: DESODBC Developer
+*/
+SQLRETURN DBC::read_DES_output_unix(size_t &used, int timeout_ms) {
+  this->reserve_recv_buffer(used);
+
+  while (true) {
+    ssize_t n = read(this->driver_to_des_out_rpipe,
+                     this->recv_buffer.data() + used,
+                     this->recv_buffer.size() - used);
+    if (n > 0) {
+      used += n;
+      return SQL_SUCCESS;
+    } else if (n == 0) {
+      return this->set_unix_error("DES closed its output pipe", false);
+    } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      int ready = wait_for_pipe_input(this->driver_to_des_out_rpipe, timeout_ms);
+      if (ready == -1)
+        return this->set_unix_error("Error waiting for DES output pipe",
+                                    true);
+      if (ready == 0) return SQL_NO_DATA;
+    } else if (errno != EINTR) {
+      return this->set_unix_error("Error reading DES output pipe", true);
+    }
+  }
 }
 #endif
 
+/* DESODBC:
+  This function tells how long a read of the reply may wait for DES output
+  before checking whether the reply has to be abandoned: until its
+  deadline, and on Unix-like systems at most REPLY_POLL_MS so that
+  SQLCancel is noticed. On Windows, without a deadline, the read blocks and
+  a cancellation is noticed when DES writes something. -1 means no limit.
+
+  Original author: DESODBC Developer
+*/
+static int reply_wait_ms(DBC *dbc) {
+  int wait_ms = -1;
+  if (dbc->reply_deadline != std::chrono::steady_clock::time_point::max()) {
+    long long left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         dbc->reply_deadline - std::chrono::steady_clock::now())
+                         .count();
+    wait_ms = left > 0 ? (int)std::min<long long>(left, INT_MAX) : 0;
+  }
+#ifndef _WIN32
+  if (wait_ms < 0 || wait_ms > REPLY_POLL_MS) wait_ms = REPLY_POLL_MS;
+#endif
+  return wait_ms;
+}
+
+/* DESODBC:
+  This function tells whether the reply being read has to be abandoned
+  (see abandon_DES_reply). While skipping the rest of an abandoned reply,
+  only its deadline counts.
+
+  Original author: DESODBC Developer
+*/
+bool DBC::reply_interrupted() {
+  if (!this->resyncing && this->cancel_requested) return true;
+  return std::chrono::steady_clock::now() >= this->reply_deadline;
+}
+
+/* DESODBC:
+  This function gives up the reply being read, because its deadline has
+  passed or SQLCancel was called. DES is interrupted and the rest of the
+  reply is skipped up to its end marker, so that the DES process (which
+  may be shared with other connections) can take new commands. If the end
+  marker does not arrive in RESYNC_TIMEOUT_MS, DES is terminated.
+
+  Original author: DESODBC Developer
+*/
+SQLRETURN DBC::abandon_DES_reply() {
+  bool cancelled = this->cancel_requested;
+  this->cancel_requested = false;
+
+  this->interrupt_DES();
+
+  DESReplyDiscard discard;
+  this->resyncing = true;
+  this->reply_deadline = std::chrono::steady_clock::now() +
+                         std::chrono::milliseconds(RESYNC_TIMEOUT_MS);
+  SQLRETURN ret = this->continue_DES_reply(discard);
+  this->resyncing = false;
+  this->reply_deadline = std::chrono::steady_clock::time_point::max();
+  this->reply_abandoned = true;
+
+  if (ret != SQL_SUCCESS) {
+    this->terminate_DES();
+    return this->set_error("08S01",
+                           "DES did not recover from the interruption of the "
+                           "query and has been terminated");
+  }
+
+  if (cancelled) return this->set_error("HY008", "Operation canceled");
+  return this->set_error("HYT00", "Timeout expired");
+}
+
+/* DESODBC:
+  This function skips the rest of the pending reply, which nobody is
+  waiting for. DES is given RESYNC_TIMEOUT_MS to finish printing it; after
+  that, the reply is abandoned as if its query had timed out (see
+  abandon_DES_reply), so this never takes much longer than twice that time.
+
+  Original author: DESODBC Developer
+*/
+void DBC::discard_DES_reply() {
+  DESReplyDiscard discard;
+
+  this->cancel_requested = false;
+  this->reply_deadline = std::chrono::steady_clock::now() +
+                         std::chrono::milliseconds(RESYNC_TIMEOUT_MS);
+  this->continue_DES_reply(discard);
+  this->reply_deadline = std::chrono::steady_clock::time_point::max();
+}
+
+/* DESODBC:
+  This function asks DES to stop the command it is running, as Ctrl+C
+  would. Windows offers no such signal for a process without a console of
+  its own, so there DES goes on until it finishes or it is terminated.
+
+  Original author: DESODBC Developer
+*/
+void DBC::interrupt_DES() {
+#ifndef _WIN32
+  if (this->use_broker)
+    this->write_DES_input(std::string(BROKER_INTERRUPT) + "\n");
+  else if (this->shmem && this->shmem->DES_pid > 0)
+    kill(this->shmem->DES_pid, SIGINT);
+#endif
+}
+
+/* DESODBC:
+  Original author: DESODBC Developer
+*/
+void DBC::terminate_DES() {
 #ifdef _WIN32
-std::pair<SQLRETURN, std::string> DBC::read_DES_output_win(
-    const std::string &query) {
-  SQLRETURN err = SQL_SUCCESS;
-  std::string tapi_output = "";
-  bool finished_reading = false;
-
-  bytes_read = 0;
-
-  while (!finished_reading) {
-    int ms = 0;
-    while (ms < MAX_OUTPUT_WAIT_MS && bytes_read == 0) {
-      HANDLE read_thread = CreateThread(NULL, 0, read_process,
-                                        this->driver_to_des_out_rpipe, 0, NULL);
-      if (!read_thread) {
-        err = this->set_win_error("Failed to peek DES output", true);
-        return {err, ""};
-      }
+  HANDLE des_process_handle =
+      OpenProcess(PROCESS_TERMINATE, false, this->shmem->DES_pid);
+  if (des_process_handle != NULL) {
+    TerminateProcess(des_process_handle, 1);
+    CloseHandle(des_process_handle);
+  }
+#else
+  if (this->use_broker)
+    this->write_DES_input(std::string(BROKER_TERMINATE) + "\n");
+  else if (this->shmem && this->shmem->DES_pid > 0)
+    kill(this->shmem->DES_pid, SIGKILL);
+#endif
+}
+
+/* DESODBC:
+  This function starts reading the reply to a command, handing every line
+  printed between both of its markers to sink as soon as it arrives.
 
-      Sleep(10);
-      ms += 10;
+  Original author: DESODBC Developer
+*/
+SQLRETURN DBC::read_DES_reply(const std::string &begin_marker,
+                              const std::string &end_marker,
+                              DESReplySink &sink) {
+  this->reply_begin_marker = begin_marker;
+  this->reply_end_marker = end_marker;
+  this->reply_started = false;
+  this->reply_pending = true;
+
+  return this->continue_DES_reply(sink);
+}
 
-      // We will not handle errors for these because I/O is highly
-      // unpredictable.
-      CancelSynchronousIo(read_thread);  // if it is reading actual data, it
-                                         // will not interrupt the reading pipe.
-      WaitForSingleObject(read_thread, MUTEX_TIMEOUT);
+/* DESODBC:
+  This function goes on reading the pending reply until its end marker, or
+  until sink pauses it; in the latter case, reply_pending is still true
+  when it returns. Lines already handed are dropped from the receive buffer,
+  so it only needs to hold the line being read.
 
-      DWORD code;
-      if (GetExitCodeThread(read_thread, &code) != 0) {
-        if (code == -1) {
-          err = this->set_win_error("Failed to read DES output", true);
-          return {err, ""};
+  Original author: DESODBC Developer
+*/
+SQLRETURN DBC::continue_DES_reply(DESReplySink &sink) {
+  SQLRETURN ret = SQL_SUCCESS;
+  size_t &used = this->recv_used;  // bytes in the receive buffer
+  size_t line_start = 0;           // first byte not handed yet
+  size_t scan_from = 0;            // first byte not searched for '\n' yet
+  bool pause = false;
+
+  while (true) {
+    const char *data = this->recv_buffer.data();
+    const char *nl;
+    while (!pause && scan_from < used &&
+           (nl = (const char *)memchr(data + scan_from, '\n',
+                                      used - scan_from)) != nullptr) {
+      size_t line_end = nl - data;
+      std::string_view line(data + line_start, line_end - line_start);
+      size_t marker_pos = 0;
+
+      if (!this->reply_started) {
+        this->reply_started =
+            line_ends_with_marker(line, this->reply_begin_marker, marker_pos);
+      } else if (line_ends_with_marker(line, this->reply_end_marker,
+                                       marker_pos)) {
+        // The reply may not have ended in '\n'
+        if (marker_pos > 0) sink.on_line(line.substr(0, marker_pos), false);
+
+        used -= line_end + 1;
+        memmove(this->recv_buffer.data(), data + line_end + 1, used);
+        if (this->recv_buffer.size() > RECV_BUFFER_KEEP_SIZE &&
+            used < RECV_BUFFER_KEEP_SIZE) {
+          this->recv_buffer.resize(RECV_BUFFER_KEEP_SIZE);
+          this->recv_buffer.shrink_to_fit();
         }
+        this->reply_pending = false;
+        return SQL_SUCCESS;
+      } else {
+        sink.on_line(line, true);
+        pause = sink.paused();
       }
+
+      line_start = scan_from = line_end + 1;
+    }
+    if (!pause) scan_from = used;
+
+    // We keep only the incomplete line at the beginning of the buffer.
+    if (line_start > 0) {
+      memmove(this->recv_buffer.data(), data + line_start, used - line_start);
+      used -= line_start;
+      scan_from -= line_start;
+      line_start = 0;
     }
-    if (bytes_read > 0) {
-      std::string buffer_str = buffer;
-      tapi_output += buffer_str;
 
-      finished_reading = check_stop(query, tapi_output);
-      bytes_read = 0;
-    } else
-      finished_reading = true;
+    if (pause) return SQL_SUCCESS;
+
+#ifdef _WIN32
+    ret = this->read_DES_output_win(used, reply_wait_ms(this));
+#else
+    ret = this->read_DES_output_unix(used, reply_wait_ms(this));
+#endif
+    if (ret == SQL_SUCCESS || ret == SQL_NO_DATA) {
+      if (!this->reply_interrupted()) continue;
+      if (!this->resyncing) return this->abandon_DES_reply();
+      ret = SQL_ERROR;
+    }
+
+    this->reply_pending = false;
+    used = 0;
+    return ret;
+  }
+}
+
+/* DESODBC:
+  This function makes DES ready to take a new command: a reply being
+  drained in the background is waited for, and the rows left of a streamed
+  answer are read into its table.
+
+  Original author: DESODBC Developer
+*/
+SQLRETURN DBC::finish_pending_reply() {
+  if (this->drain_thread) {
+    if (this->drain_thread->joinable()) this->drain_thread->join();
+    this->drain_thread.reset();
   }
 
-  return {err, tapi_output};
+  if (this->active_stream) return this->active_stream->read_all();
+
+  return SQL_SUCCESS;
 }
-#else
-std::pair<SQLRETURN, std::string> DBC::read_DES_output_unix(
-    const std::string &query) {
-  SQLRETURN err = SQL_SUCCESS;
-  std::string tapi_output = "";
-  bool finished_reading = false;
-  bytes_read = 0;
-
-  while (!finished_reading) {
-    int ms = 0;
-    while (ms < MAX_OUTPUT_WAIT_MS && bytes_read == 0) {
-      usleep(10000);
-      ms += 10;
-      ioctl(this->driver_to_des_out_rpipe, FIONREAD, &bytes_read);
+
+/* DESODBC:
+  This function goes on reading the answer from DES into sink. SQLCancel
+  and the query timeout of the statement apply to each read as they do to
+  the first one (see DES_do_query), also when it is done on behalf of
+  another command.
+
+  Original author: DESODBC Developer
+*/
+SQLRETURN DESRowStream::continue_reply(DESReplySink &sink) {
+  DBC *dbc = this->dbc;
+  STMT *previous_stmt = dbc->executing_stmt;
+  auto previous_deadline = dbc->reply_deadline;
+
+  dbc->cancel_requested = false;
+  if (this->stmt->stmt_options.query_timeout > 0)
+    dbc->reply_deadline =
+        std::chrono::steady_clock::now() +
+        std::chrono::seconds(this->stmt->stmt_options.query_timeout);
+  dbc->executing_stmt = this->stmt;
+
+  SQLRETURN ret = dbc->continue_DES_reply(sink);
+
+  dbc->executing_stmt = previous_stmt;
+  dbc->reply_deadline = previous_deadline;
+  return ret;
+}
+
+/* DESODBC:
+  This function goes on parsing the answer into the table, from DES or,
+  once it has been spilled (see watch_idle), from memory.
+
+  Original author: DESODBC Developer
+*/
+SQLRETURN DESRowStream::continue_parsing() {
+  if (!this->spilled) return this->continue_reply(this->parser);
+
+  while (this->spill_pos < this->spill.size() && !this->parser.paused()) {
+    size_t nl = this->spill.find('\n', this->spill_pos);
+    bool newline = nl != std::string::npos;
+    if (!newline) nl = this->spill.size();
+    this->parser.on_line(std::string_view(this->spill.data() + this->spill_pos,
+                                          nl - this->spill_pos),
+                         newline);
+    this->spill_pos = newline ? nl + 1 : nl;
+  }
+
+  if (this->spill_pos < this->spill.size() || this->spill_ret == SQL_SUCCESS)
+    return SQL_SUCCESS;
+  return this->dbc->set_error(
+      "HY000", "The rest of the answer of an idle cursor could not be read");
+}
+
+/* DESODBC:
+  Original author: DESODBC Developer
+*/
+bool DESRowStream::reply_left() {
+  return this->spilled ? this->spill_pos < this->spill.size()
+                       : this->dbc->reply_pending;
+}
+
+/* DESODBC:
+  This function makes the table hold at least wanted rows that have not
+  been fetched yet, unless DES has no more of them. The fetched ones are
+  removed first, so the table never holds more than a window.
+
+  Original author: DESODBC Developer
+*/
+SQLRETURN DESRowStream::read_rows(size_t wanted) {
+  std::lock_guard<std::mutex> guard(this->lock);
+  SQLRETURN ret = SQL_SUCCESS;
+  size_t held = this->table->row_count();
+
+  if (this->pending && this->first_row + held - this->next_row < wanted) {
+    this->table->remove_first_rows(this->next_row - this->first_row);
+    this->first_row = this->next_row;
+
+    this->parser.window_rows = std::max(wanted, (size_t)STREAM_WINDOW_ROWS);
+    ret = this->continue_parsing();
+    if (!this->reply_left()) this->read_all_locked();
+  }
+
+  // The table may have grown (or moved) since the index was built,
+  // also when the rest of the answer was read on behalf of other commands
+  if (this->index_first != this->first_row ||
+      this->index_rows != this->table->row_count()) {
+    this->index_first = this->first_row;
+    this->index_rows = this->table->row_count();
+    this->cells.resize(this->index_rows * this->table->col_count());
+    this->lengths.resize(this->cells.size());
+    this->table->fill_row_index(this->cells.data(), this->lengths.data());
+  }
+
+  this->last_read = std::chrono::steady_clock::now();
+  return ret;
+}
+
+/* DESODBC:
+  This function reads the rest of the answer into the table and leaves DES
+  ready for other commands.
+
+  Original author: DESODBC Developer
+*/
+SQLRETURN DESRowStream::read_all() {
+  std::lock_guard<std::mutex> guard(this->lock);
+  return this->read_all_locked();
+}
+
+/* DESODBC:
+  As read_all, with lock held.
+
+  Original author: DESODBC Developer
+*/
+SQLRETURN DESRowStream::read_all_locked() {
+  SQLRETURN ret = SQL_SUCCESS;
+
+  if (this->pending && this->reply_left()) {
+    this->parser.window_rows = 0;
+    ret = this->continue_parsing();
+  }
+  this->pending = false;
+  this->dbc->active_stream = nullptr;
+  this->wake.notify_all();
+
+  if (this->holds_query_mutex) {
+    this->holds_query_mutex = false;
+    SQLRETURN release_ret = this->dbc->release_query_mutex();
+    if (ret == SQL_SUCCESS) ret = release_ret;
+  }
+
+  return ret;
+}
+
+/* DESODBC:
+  This function starts the thread that watches whether the cursor is idle
+  (see watch_idle).
+
+  Original author: DESODBC Developer
+*/
+void DESRowStream::start_idle_watch() {
+  this->last_read = std::chrono::steady_clock::now();
+  this->idle_watch.reset(new std::thread(&DESRowStream::watch_idle, this));
+}
+
+/* DESODBC:
+  Original author: DESODBC Developer
+*/
+void DESRowStream::stop_idle_watch() {
+  if (!this->idle_watch) return;
+
+  {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->stop_watching = true;
+  }
+  this->wake.notify_all();
+  if (this->idle_watch->joinable()) this->idle_watch->join();
+  this->idle_watch.reset();
+}
+
+/* DESODBC:
+  This function runs in a thread of its own while the stream holds the
+  query mutex. Once the cursor has not been fetched from for
+  STREAM_IDLE_TIMEOUT_MS and another connection waits for the mutex, it
+  reads the rest of the answer into memory, where the cursor goes on
+  parsing it from, and releases the mutex. As the thread that discards a
+  closed stream, it records no errors (see DBC::discarding_in_background);
+  those of the read are reported when the cursor gets to them.
+
+  Original author: DESODBC Developer
+*/
+void DESRowStream::watch_idle() {
+  std::unique_lock<std::mutex> guard(this->lock);
+  auto idle = std::chrono::milliseconds(STREAM_IDLE_TIMEOUT_MS);
+
+  while (!this->stop_watching && this->pending && !this->spilled) {
+    auto idle_end = this->last_read + idle;
+    if (std::chrono::steady_clock::now() < idle_end ||
+        !this->dbc->query_mutex_wanted()) {
+      this->wake.wait_until(
+          guard, std::max(idle_end, std::chrono::steady_clock::now() + idle));
+      continue;
     }
-    if (bytes_read > 0) {
-      bytes_read = read(this->driver_to_des_out_rpipe, buffer, sizeof(buffer));
-      if (bytes_read == -1) {
-        return {this->set_unix_error("Error reading DES output pipe", true),
-                ""};
-      }
-      buffer[bytes_read] = '\0';
-      std::string buffer_str = buffer;
-      tapi_output += buffer_str;
 
-      finished_reading = check_stop(query, tapi_output);
+    DBC::discarding_in_background = true;
+    DESReplyText sink(this->spill);
+    this->spill_ret =
+        this->dbc->reply_pending ? this->continue_reply(sink) : SQL_SUCCESS;
+    this->spilled = true;
+
+    if (this->holds_query_mutex) {
+      this->holds_query_mutex = false;
+      this->dbc->release_query_mutex();
+    }
+  }
+}
+
+/* DESODBC:
+  This function returns the next row of the stream, or nullptr if there
+  are no more rows in its window.
+
+  Original author: DESODBC Developer
+*/
+DES_ROW DESRowStream::fetch_row() {
+  if (this->next_row < this->index_first ||
+      this->next_row >= this->index_first + this->index_rows)
+    return nullptr;
+
+  DES_ROW row = this->cells.data() + (this->next_row - this->index_first) *
+                                         this->table->col_count();
+  this->next_row++;
+
+  return row;
+}
 
-      bytes_read = 0;
+/* DESODBC:
+  This function is called when the cursor is closed. If DES is still
+  printing the answer, the rest of it is discarded (see
+  DBC::discard_DES_reply). In Unix, this is done by a thread, so the
+  application does not wait for it unless it sends another command
+  meanwhile; the errors of that thread are not recorded (see
+  DBC::discarding_in_background). In Windows, the query mutex can only be
+  released by the thread that owns it, so the answer is discarded right
+  away.
 
-    } else
-      finished_reading = true;
+  Original author: DESODBC Developer
+*/
+void DESRowStream::close() {
+  this->stop_idle_watch();
+  if (!this->pending) return;
+
+  DBC *dbc = this->dbc;
+  dbc->active_stream = nullptr;
+  this->pending = false;
+
+  if (!dbc->reply_pending) {
+    if (this->holds_query_mutex) dbc->release_query_mutex();
+    this->holds_query_mutex = false;
+    return;
   }
 
-  return {err, tapi_output};
+#ifdef _WIN32
+  dbc->discard_DES_reply();
+  if (this->holds_query_mutex) dbc->release_query_mutex();
+#else
+  bool release = this->holds_query_mutex;
+  dbc->drain_thread.reset(new std::thread([dbc, release]() {
+    DBC::discarding_in_background = true;
+    dbc->discard_DES_reply();
+    if (release) dbc->release_query_mutex();
+  }));
+#endif
+  this->holds_query_mutex = false;
+}
+
+/* DESODBC:
+  Original author: DESODBC Developer
+*/
+DES_ROW stream_fetch_row(DESRowStream *stream) { return stream->fetch_row(); }
+
+/* DESODBC:
+  Original author: DESODBC Developer
+*/
+void close_row_stream(DESRowStream *stream) {
+  stream->close();
+  delete stream;
 }
+
+/* DESODBC:
+  This function writes data into the DES input pipe. On Unix-like
+  systems, the pipe is non-blocking, so we wait for room in it whenever
+  it is full.
+
+  Original author: DESODBC Developer
+*/
+SQLRETURN DBC::write_DES_input(const std::string &data) {
+#ifdef _WIN32
+  DWORD bytes_written;
+  while (!this->driver_to_des_in_wpipe || !this->driver_to_des_out_rpipe)
+    this->get_DES_process_pipes();
+  if (!WriteFile(this->driver_to_des_in_wpipe, data.c_str(), data.size(),
+                 &bytes_written, NULL))
+    return this->set_win_error("Failed to send data to DES input", true);
+#else
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t n = write(this->driver_to_des_in_wpipe, data.c_str() + written,
+                      data.size() - written);
+    if (n >= 0) {
+      written += n;
+    } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      struct pollfd pfd;
+      pfd.fd = this->driver_to_des_in_wpipe;
+      pfd.events = POLLOUT;
+      pfd.revents = 0;
+      poll(&pfd, 1, -1);
+    } else if (errno != EINTR) {
+      return this->set_unix_error("Failed to send data to DES input", true);
+    }
+  }
 #endif
+  return SQL_SUCCESS;
+}
+
 /* DESODBC:
-  This function sends a query and reads the output. It returns the output
-  and whether there was a success or not.
+  This function sends a query and hands its output to sink
+  as it is read.
 
   Original author: DESODBC Developer
 */
-std::pair<SQLRETURN, std::string> DBC::send_query_and_read(
-    const std::string &query) {
-  int error = SQL_ERROR, native_error = 0;
-  bool read_success = false;
-  bool finished_reading = false;
-  char *full_query_arr = nullptr;
-  std::string tapi_output = "";
+SQLRETURN DBC::send_query_and_read(const std::string &query,
+                                   DESReplySink &sink) {
   std::string full_query = "";
   DWORD bytes_written;
 
-  full_query = "/tapi " + query + '\n';  // query for the launched DES process
+  // If we send /q, we cannot read anything after that.
+  bool is_quit = query == "/q";
+
+  SQLRETURN ret = this->finish_pending_reply();
+  if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) return ret;
 
-  // We convert the string to a char*.
-  full_query_arr =
-      new char[full_query.size() +
-               sizeof(char)];  // we hold a final char for the delimiter '\0'
-  std::copy(full_query.begin(), full_query.end(), full_query_arr);
-  full_query_arr[full_query.size()] = '\0';
+  this->reply_abandoned = false;
+
+  std::pair<std::string, std::string> markers;
+  full_query = "/tapi " + query + '\n';  // query for the launched DES process
+  if (!is_quit) {
+    markers = this->next_reply_markers();
+    full_query = "/tapi /writeln " + markers.first + '\n' + full_query +
+                 "/tapi /writeln " + markers.second + '\n';
+  }
 
 #ifdef _WIN32
   while (!this->driver_to_des_in_wpipe || !this->driver_to_des_out_rpipe)
     this->get_DES_process_pipes();
-  if (!WriteFile(this->driver_to_des_in_wpipe, full_query_arr,
-                 strlen(full_query_arr), &bytes_written,
+  if (!WriteFile(this->driver_to_des_in_wpipe, full_query.c_str(),
+                 full_query.size(), &bytes_written,
                  NULL)) {  // as we explained in the connection part,
                            // the final argument must be not null only when the
                            // pipe was created with overlapping
-    error = this->set_win_error("Failed to send data to DES input", true);
-    return {error, ""};
+    return this->set_win_error("Failed to send data to DES input", true);
   }
 #else
-  if (write(this->driver_to_des_in_wpipe, full_query_arr,
-            strlen(full_query_arr)) == -1) {
-    perror("write");
-  }
+  // A socket of the DES broker may take only part of the query at a time
+  ret = this->write_DES_input(full_query);
+  if (ret != SQL_SUCCESS) return ret;
 #endif
 
-  delete[] full_query_arr;
-  full_query_arr = nullptr;
+  if (is_quit) return SQL_SUCCESS;
 
-  // If we send /q, we cannot read anything after that.
-  if (query == "/q") return {SQL_SUCCESS, ""};
+  return this->read_DES_reply(markers.first, markers.second, sink);
+}
 
-    /*
-        Same considerations as those we took when reading the startup DES
-       message. However, that output message had a fixed length and behavior. We
-       introduce some new logic when treating a command output.
-    */
+/* DESODBC:
+  This function sends a query and reads the output. It returns the output
+  and whether there was a success or not.
 
-#ifdef _WIN32
-  auto pair = this->read_DES_output_win(query);
-#else
-  auto pair = this->read_DES_output_unix(query);
-#endif
-  error = pair.first;
-  tapi_output = pair.second;
+  Original author: DESODBC Developer
+*/
+std::pair<SQLRETURN, std::string> DBC::send_query_and_read(
+    const std::string &query) {
+  std::string tapi_output = "";
+  DESReplyText sink(tapi_output);
+
+  SQLRETURN error = this->send_query_and_read(query, sink);
 
   return {error, tapi_output};
 }
 
+/* DESODBC:
+  This function sends several independent queries and reads their outputs,
+  in order. Instead of waiting for each reply before sending the next
+  query, the framed queries are written together, so the round trip to
+  DES is paid once per batch rather than once per query. They are written
+  in chunks of at most PIPELINE_MAX_BYTES, and the replies of a chunk are
+  read before the next one is written: a chunk always fits in the input
+  pipe, so DES never has to wait for us to read its output while we wait
+  for it to read our input.
+
+  If a reply cannot be read, fewer outputs than queries are returned,
+  together with its error. The queries of its chunk that come after it
+  may still be run by DES; their replies are skipped by the next command.
+
+  Original author: DESODBC Developer
+*/
+std::pair<SQLRETURN, std::vector<std::string>> DBC::send_queries_and_read(
+    const std::vector<std::string> &queries) {
+  std::vector<std::string> outputs;
+  outputs.reserve(queries.size());
+
+  SQLRETURN ret = this->finish_pending_reply();
+  if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO)
+    return {ret, outputs};
+
+  this->reply_abandoned = false;
+
+  size_t next = 0;
+  while (next < queries.size()) {
+    std::string chunk = "";
+    std::vector<std::pair<std::string, std::string>> chunk_markers;
+    while (next < queries.size()) {
+      std::pair<std::string, std::string> markers = this->next_reply_markers();
+      std::string framed = "/tapi /writeln " + markers.first + '\n' +
+                           "/tapi " + queries[next] + '\n' +
+                           "/tapi /writeln " + markers.second + '\n';
+      // A query that does not fit in a chunk by itself is sent alone
+      if (!chunk.empty() && chunk.size() + framed.size() > PIPELINE_MAX_BYTES)
+        break;
+      chunk += framed;
+      chunk_markers.push_back(markers);
+      ++next;
+    }
+
+    ret = this->write_DES_input(chunk);
+    if (ret != SQL_SUCCESS) return {ret, outputs};
+
+    for (auto &markers : chunk_markers) {
+      std::string tapi_output = "";
+      DESReplyText sink(tapi_output);
+      ret = this->read_DES_reply(markers.first, markers.second, sink);
+      if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO)
+        return {ret, outputs};
+      outputs.push_back(std::move(tapi_output));
+    }
+  }
+
+  return {SQL_SUCCESS, outputs};
+}
+
 /* DESODBC:
   This function sends a query and buils the resulting
   DES_RESULT* structure.
@@ -338,9 +950,9 @@ int STMT::send_select_count(std::string query) {
   if (tapi_output.find("$error") != std::string::npos)
     return this->set_error("HY000", "Internal query error");
 
-  std::vector<std::string> lines = getLines(tapi_output);
+  std::vector<std::string_view> lines = getLines(tapi_output);
 
-  ret = stoi(lines[4]);
+  ret = stoi(std::string(lines[4]));
 
   return ret;
 }
@@ -359,7 +971,6 @@ std::pair<SQLRETURN, std::string> STMT::send_update_and_fetch_info(
   ret = pair.first;
   std::string tapi_output = pair.second;
   if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) {
-    this->dbc->release_query_mutex();
     return {ret, tapi_output};
   }
 
@@ -388,6 +999,127 @@ SQLRETURN STMT::build_results() {
   return check_and_set_errors(SQL_HANDLE_STMT, this, this->last_output);
 }
 
+/* DESODBC:
+  Original author: DESODBC Developer
+*/
+AsyncWorker::AsyncWorker() : thread(&AsyncWorker::run, this) {}
+
+/* DESODBC:
+  Original author: DESODBC Developer
+*/
+AsyncWorker::~AsyncWorker() {
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    stopping = true;
+  }
+  wakeup.notify_one();
+  if (thread.joinable()) thread.join();
+}
+
+/* DESODBC:
+  Original author: DESODBC Developer
+*/
+void AsyncWorker::submit(Job job) {
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    jobs.push_back(std::move(job));
+  }
+  wakeup.notify_one();
+}
+
+/* DESODBC:
+  Original author: DESODBC Developer
+*/
+void AsyncWorker::run() {
+  std::unique_lock<std::mutex> guard(mutex);
+  while (true) {
+    wakeup.wait(guard, [this]() { return stopping || !jobs.empty(); });
+    if (jobs.empty()) return;
+
+    Job job = std::move(jobs.front());
+    jobs.pop_front();
+    guard.unlock();
+
+    job.task();
+#ifdef SQL_ATTR_ASYNC_STMT_PCALLBACK
+    if (job.callback)
+      ((SQL_ASYNC_NOTIFICATION_CALLBACK)job.callback)(job.context, TRUE);
+#endif
+
+    guard.lock();
+  }
+}
+
+/* DESODBC:
+  This function hands work (an execution of the statement) to the worker
+  of the connection and returns SQL_STILL_EXECUTING. The application then
+  calls the same function again, which goes to poll_async, until it
+  returns the result of work.
+
+  Original author: DESODBC Developer
+*/
+SQLRETURN STMT::start_async(SQLUSMALLINT function,
+                            std::function<SQLRETURN()> work) {
+  STMT *stmt = this;
+  std::packaged_task<SQLRETURN()> task([stmt, work]() -> SQLRETURN {
+    // SQLCancel was called before the worker got to this statement
+    if (stmt->async_cancel)
+      return stmt->set_error("HY008", "Operation canceled");
+    try {
+      return work();
+    } catch (DESERROR &e) {
+      return e.retcode;
+    } catch (const std::bad_alloc &e) {
+      return stmt->set_error("HY001", "Memory allocation error");
+    }
+  });
+
+  async_cancel = false;
+  async_function = function;
+  async_result = task.get_future();
+
+  {
+    LOCK_DBC(dbc);
+    if (!dbc->async_worker) dbc->async_worker.reset(new AsyncWorker());
+  }
+  dbc->async_worker->submit({std::move(task), async_callback, async_context});
+
+  return SQL_STILL_EXECUTING;
+}
+
+/* DESODBC:
+  This function returns the result of the asynchronous execution started
+  by start_async, or SQL_STILL_EXECUTING if it has not finished yet.
+
+  Original author: DESODBC Developer
+*/
+SQLRETURN STMT::poll_async(SQLUSMALLINT function) {
+  if (function != async_function)
+    return set_error("HY010", "Function sequence error");
+
+  if (async_result.wait_for(std::chrono::seconds(0)) !=
+      std::future_status::ready)
+    return SQL_STILL_EXECUTING;
+
+  async_function = 0;
+  return async_result.get();
+}
+
+/* DESODBC:
+  This function waits for the asynchronous execution of the statement, if
+  there is one, and discards its result: the application closes the
+  statement instead of polling it.
+
+  Original author: DESODBC Developer
+*/
+void STMT::finish_async() {
+  if (!async_result.valid()) return;
+
+  async_result.wait();
+  async_result = std::future<SQLRETURN>();
+  async_function = 0;
+}
+
 /* DESODBC:
   Function that executes a query into the DES executable (through its
   STDIN pipe), and loads its result into a internal table, structure held by the
@@ -400,6 +1132,8 @@ SQLRETURN DES_do_query(STMT *stmt, std::string query) {
   SQLRETURN error = SQL_SUCCESS;
   std::string tapi_output = "";
   SQLRETURN release_mutex_err = SQL_SUCCESS;
+  // The query mutex is then kept by the stream of rows
+  bool streaming = false;
 
   assert(stmt);
   LOCK_STMT_DEFER(stmt);
@@ -412,6 +1146,14 @@ SQLRETURN DES_do_query(STMT *stmt, std::string query) {
   error = stmt->dbc->get_query_mutex();
   if (error != SQL_SUCCESS && error != SQL_SUCCESS_WITH_INFO) return error;
 
+  // SQLCancel and the query timeout apply while the reply is being read
+  stmt->dbc->cancel_requested = false;
+  if (stmt->stmt_options.query_timeout > 0)
+    stmt->dbc->reply_deadline =
+        std::chrono::steady_clock::now() +
+        std::chrono::seconds(stmt->stmt_options.query_timeout);
+  stmt->dbc->executing_stmt = stmt;
+
   switch (stmt->type) {
     case INSERT:
     case UPDATE:
@@ -420,6 +1162,41 @@ SQLRETURN DES_do_query(STMT *stmt, std::string query) {
       error = pair.first;
       tapi_output = pair.second;
       break;
+    case SELECT: {
+      /*
+        The answer is parsed as it is read from DES. If it turns out not to
+        be a SELECT answer (e.g., an error), we go on with its text as usual.
+        Forward-only cursors without cache only read the first window of
+        rows here; the rest are read as they are fetched.
+      */
+      ResultTable *table = new ResultTable();
+      table->set_params(stmt);
+      DESRowStream *stream = new DESRowStream(stmt->dbc, table);
+      stream->stmt = stmt;
+      TapiSelectParser &parser = stream->parser;
+      if (if_forward_cache(stmt)) parser.window_rows = STREAM_WINDOW_ROWS;
+
+      error = stmt->dbc->send_query_and_read(query, parser);
+      if (parser.is_select() &&
+          (error == SQL_SUCCESS || error == SQL_SUCCESS_WITH_INFO)) {
+        stmt->streamed_table = table;
+        tapi_output = parser.trailing;
+        if (stmt->dbc->reply_pending) {
+          stream->pending = stream->holds_query_mutex = true;
+          stmt->dbc->active_stream = stmt->row_stream = stream;
+          streaming = true;
+#ifndef _WIN32
+          stream->start_idle_watch();
+#endif
+        } else
+          delete stream;
+      } else {
+        delete stream;
+        free_result(table);
+        tapi_output = parser.raw;
+      }
+      break;
+    }
     default:
       pair = stmt->dbc->send_query_and_read(query);
       error = pair.first;
@@ -427,20 +1204,31 @@ SQLRETURN DES_do_query(STMT *stmt, std::string query) {
       break;
   }
 
-  // We parse the TAPI output and create an internal table from the result view
-  stmt->last_output = tapi_output;
+  stmt->dbc->executing_stmt = nullptr;
+  stmt->dbc->reply_deadline = std::chrono::steady_clock::time_point::max();
 
-  error = stmt->build_results();
+  /*
+    The reply has been completely read at this point (unless it is being
+    streamed), so other connections may use DES while we parse it.
+  */
+  if (!streaming) {
+    release_mutex_err = stmt->dbc->release_query_mutex();
+    if (release_mutex_err != SQL_SUCCESS &&
+        release_mutex_err != SQL_SUCCESS_WITH_INFO)
+      return release_mutex_err;
+  }
 
-  if (error != SQL_SUCCESS && error != SQL_SUCCESS_WITH_INFO) {
-    stmt->dbc->release_query_mutex();
-    return error;
+  // The query timed out or was canceled: there is nothing to parse
+  if (stmt->dbc->reply_abandoned) {
+    stmt->error = stmt->dbc->error;
+    error = stmt->error.retcode;
+    goto exit;
   }
 
-  release_mutex_err = stmt->dbc->release_query_mutex();
-  if (release_mutex_err != SQL_SUCCESS &&
-      release_mutex_err != SQL_SUCCESS_WITH_INFO)
-    return error;
+  // We parse the TAPI output and create an internal table from the result view
+  stmt->last_output = tapi_output;
+
+  error = stmt->build_results();
 
 exit:
   /*
@@ -454,6 +1242,75 @@ exit:
   return error;
 }
 
+/* DESODBC:
+  Function that executes several data modification queries of a statement
+  (the ones built from an array of parameters) as a pipelined batch (see
+  DBC::send_queries_and_read). The output of each query is handled as
+  DES_do_query does, and its return code is put into results, in order.
+  Only INSERT, UPDATE and DELETE queries are given to it.
+
+  Original author: DESODBC Developer
+*/
+SQLRETURN DES_do_query_batch(STMT *stmt,
+                             const std::vector<std::string> &queries,
+                             std::vector<SQLRETURN> &results) {
+  SQLRETURN error = SQL_SUCCESS;
+
+  assert(stmt);
+  LOCK_STMT_DEFER(stmt);
+
+  results.clear();
+
+  error = stmt->dbc->get_query_mutex();
+  if (error != SQL_SUCCESS && error != SQL_SUCCESS_WITH_INFO) {
+    stmt->error = stmt->dbc->error;
+    results.resize(queries.size(), error);
+    return error;
+  }
+
+  // The query timeout applies to the whole batch
+  stmt->dbc->cancel_requested = false;
+  if (stmt->stmt_options.query_timeout > 0)
+    stmt->dbc->reply_deadline =
+        std::chrono::steady_clock::now() +
+        std::chrono::seconds(stmt->stmt_options.query_timeout);
+  stmt->dbc->executing_stmt = stmt;
+
+  auto pair = stmt->dbc->send_queries_and_read(queries);
+
+  stmt->dbc->executing_stmt = nullptr;
+  stmt->dbc->reply_deadline = std::chrono::steady_clock::time_point::max();
+
+  stmt->dbc->release_query_mutex();
+
+  for (const std::string &tapi_output : pair.second) {
+    switch (stmt->type) {
+      case INSERT:
+      case UPDATE:
+      case DEL:
+        if (tapi_output.find("$error") == std::string::npos)
+          stmt->affected_rows = stoll(tapi_output);
+        break;
+      default:
+        break;
+    }
+    stmt->last_output = tapi_output;
+    results.push_back(stmt->build_results());
+  }
+
+  // The queries whose outputs could not be read
+  if (results.size() < queries.size()) {
+    stmt->error = stmt->dbc->error;
+    results.resize(queries.size(), stmt->error.retcode);
+  }
+
+  if (GET_QUERY(&stmt->orig_query)) {
+    stmt->query = stmt->orig_query;
+    stmt->orig_query.reset(NULL, NULL, NULL);
+  }
+  return pair.first;
+}
+
 /*
 @type    : myodbc3 internal
 @purpose : insert sql params at parameter positions
@@ -1268,9 +2125,22 @@ exist in the statement
 */
 
 SQLRETURN SQL_API SQLExecute(SQLHSTMT hstmt) {
+  CHECK_HANDLE(hstmt);
+  STMT *stmt = (STMT *)hstmt;
+
+  // The statement is locked by the worker while it is being executed
+  if (stmt->async_result.valid())
+    return stmt->poll_async(SQL_API_SQLEXECUTE);
+
   LOCK_STMT(hstmt);
 
-  return DES_SQLExecute((STMT *)hstmt);
+  if (stmt->stmt_options.async_enable == SQL_ASYNC_ENABLE_ON)
+    return stmt->start_async(SQL_API_SQLEXECUTE, [stmt]() -> SQLRETURN {
+      LOCK_STMT(stmt);
+      return DES_SQLExecute(stmt);
+    });
+
+  return DES_SQLExecute(stmt);
 }
 
 BOOL map_error_to_param_status(SQLUSMALLINT *param_status_ptr, SQLRETURN rc) {
@@ -1318,6 +2188,14 @@ SQLRETURN DES_SQLExecute(STMT *pStmt) {
   /* need to have a flag indicating if all parameters failed */
   int all_parameters_failed = pStmt->apd->array_size > 1 ? 1 : 0;
 
+  /*
+    The queries built from an array of parameters are sent to DES as a
+    pipelined batch once they are all built (but SELECTs, which are joined
+    into a single query)
+  */
+  std::vector<std::string> batch_queries;
+  std::vector<SQLUSMALLINT *> batch_status_ptrs;
+
   if (!pStmt) return SQL_ERROR;
 
   CLEAR_STMT_ERROR(pStmt);
@@ -1472,6 +2350,16 @@ SQLRETURN DES_SQLExecute(STMT *pStmt) {
       }
     }
 
+    /* Only data modification queries are batched, as they are the ones
+       whose output is the number of affected rows */
+    if (pStmt->param_count && pStmt->apd->array_size > 1 &&
+        (pStmt->type == INSERT || pStmt->type == DEL ||
+         pStmt->type == UPDATE)) {
+      batch_queries.push_back(query);
+      batch_status_ptrs.push_back(param_status_ptr);
+      continue;
+    }
+
     if (!is_select_stmt || row == pStmt->apd->array_size - 1) {
       if (!connection_failure) {
         try {
@@ -1511,6 +2399,27 @@ SQLRETURN DES_SQLExecute(STMT *pStmt) {
     }
   }
 
+  if (!batch_queries.empty()) {
+    std::vector<SQLRETURN> results;
+    try {
+      DES_do_query_batch(pStmt, batch_queries, results);
+    } catch (const std::bad_alloc &e) {
+      return pStmt->set_error("HY001", "Memory allocation error");
+    }
+
+    for (size_t i = 0; i < batch_queries.size(); ++i) {
+      rc = results[i];
+      if (map_error_to_param_status(batch_status_ptrs[i], rc)) {
+        lastError = batch_status_ptrs[i];
+      }
+      if (rc != SQL_SUCCESS) {
+        one_of_params_not_succeded = 1;
+      } else {
+        all_parameters_failed = 0;
+      }
+    }
+  }
+
   /* Changing status for last detected error to SQL_PARAM_ERROR as we have
       diagnostics for it */
   if (lastError != NULL) {
@@ -1611,6 +2520,7 @@ static SQLRETURN find_next_dae_param(STMT *stmt, SQLPOINTER *token) {
 data at statement execution time
 */
 SQLRETURN SQL_API SQLParamData(SQLHSTMT hstmt, SQLPOINTER *prbgValue) {
+  CHECK_STMT_IDLE(hstmt);
   return ((STMT *)hstmt)
       ->set_error("IM001", "Data-at-execution is not supported in DES");
 }
@@ -1629,6 +2539,7 @@ a character, binary, or data source specific data type.
 
 SQLRETURN SQL_API SQLPutData(SQLHSTMT hstmt, SQLPOINTER rgbValue,
                              SQLLEN cbValue) {
+  CHECK_STMT_IDLE(hstmt);
   return ((STMT *)hstmt)
       ->set_error("IM001", "Data-at-execution is not supported in DES");
 }
@@ -1639,15 +2550,29 @@ SQLRETURN SQL_API SQLPutData(SQLHSTMT hstmt, SQLPOINTER rgbValue,
   Modified by: DESODBC Developer
 */
 /**
-Cancel the query by opening another connection and using KILL when called
-from another thread while the query lock is being held. Otherwise, treat as
-SQLFreeStmt(hstmt, SQL_CLOSE).
+Cancel the query of the statement while DES is running it, either from
+another thread or while it is executed asynchronously. An asynchronous
+execution that the worker of the connection has not started yet is dropped.
+Otherwise, treat as SQLFreeStmt(hstmt, SQL_CLOSE).
 
 @param[in]  hstmt  Statement handle
 
 @return Standard ODBC result code
 */
 SQLRETURN SQL_API SQLCancel(SQLHSTMT hstmt) {
-  return ((STMT *)hstmt)
-      ->set_error("IM001", "DESODBC does not support this function");
+  CHECK_HANDLE(hstmt);
+  STMT *stmt = (STMT *)hstmt;
+
+  // The reader notices it and interrupts DES (see DBC::abandon_DES_reply)
+  if (stmt->dbc->executing_stmt == stmt) stmt->dbc->cancel_requested = true;
+
+  if (stmt->async_result.valid()) {
+    stmt->async_cancel = true;
+    return SQL_SUCCESS;
+  }
+
+  std::unique_lock<std::recursive_mutex> slock(stmt->lock, std::try_to_lock);
+  if (!slock.owns_lock()) return SQL_SUCCESS;
+
+  return DES_SQLFreeStmt(hstmt, SQL_CLOSE);
 }
@@ -144,13 +144,83 @@ void try_close(HANDLE h) {
 void try_close(int fd) { ::close(fd); }
 #endif
 
+#ifndef _WIN32
+/* DESODBC:
+  With DES_LINGER, the last client to disconnect leaves DES running and
+  calls this function, with the shared memory mutex held. It starts a
+  watchdog process that keeps both pipes open (so that DES does not read
+  the end of its input) and, after linger seconds, quits DES and removes
+  its shared objects unless a client has connected meanwhile. The
+  watchdog is forked twice so that it is not left as a zombie of the
+  application. It returns false if the watchdog could not be started.
+
+  The watchdog is a fork of a process that may have other threads, so it
+  only makes async-signal-safe calls: whatever it needs is computed
+  before forking, and it keeps no descriptor of the application but the
+  DES pipes.
+
+  Original author: DESODBC Developer
+*/
+bool DBC::start_linger_watchdog() {
+  unsigned int generation = ++this->shmem->linger_generation;
+  unsigned int linger = this->linger;
+  int in_fd = this->driver_to_des_in_wpipe;
+  int out_fd = this->driver_to_des_out_rpipe;
+  long max_fd = sysconf(_SC_OPEN_MAX);
+  if (max_fd < 0 || max_fd > 65536) max_fd = 65536;
+
+  pid_t pid = fork();
+  if (pid == -1) return false;
+
+  if (pid == 0) {
+    if (fork() != 0) _exit(0);
+    setsid();
+
+    for (int fd = 0; fd < max_fd; ++fd)
+      if (fd != in_fd && fd != out_fd) ::close(fd);
+
+    unsigned int left = linger;
+    while (left > 0) left = sleep(left);
+
+    if (!lock_shared_memory_mutex_in_child()) _exit(1);
+
+    if (this->shmem->n_clients == 0 &&
+        this->shmem->linger_generation == generation) {
+      const char quit[] = "/tapi /q\n";
+      if (write(in_fd, quit, sizeof(quit) - 1) == -1)
+        kill(this->shmem->DES_pid, SIGTERM);
+      this->shmem->des_process_created = false;
+      shmctl(this->shm_id, IPC_RMID, 0);
+      unlink(IN_WPIPE_NAME);
+      unlink(OUT_RPIPE_NAME);
+#ifdef __APPLE__
+      sem_unlink(QUERY_MUTEX_NAME);
+      sem_unlink(SHARED_MEMORY_MUTEX_NAME);
+#endif
+    }
+
+    unlock_shared_memory_mutex_in_child();
+    _exit(0);
+  }
+
+  while (waitpid(pid, nullptr, 0) == -1 && errno == EINTR);
+  return true;
+}
+#endif
+
 /* DESODBC:
   Original author: MyODBC
   Modified by: DESODBC Developer
 */
 SQLRETURN DBC::close() {
   SQLRETURN ret;
+  // Every statement has been freed, so the worker has nothing left to run
+  async_worker.reset();
   if (this->connected) {
+    // Nothing else will be fetched from a cursor left open
+    if (active_stream) active_stream->close();
+    finish_pending_reply();
+
 #ifdef _WIN32
     ret = get_shared_memory_mutex();
     if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) {
@@ -222,12 +292,23 @@ SQLRETURN DBC::close() {
     try_close(handle_sent_event);
     try_close(finishing_event);
 #else
+    if (this->use_broker) {
+      // The broker itself quits DES once it has no clients (see broker.cc)
+      try_close(this->driver_to_des_in_wpipe);
+      this->connected = false;
+      release_pool_slot();
+      return SQL_SUCCESS;
+    }
 
     ret = get_shared_memory_mutex();
     if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) return ret;
 
     this->shmem->n_clients -= 1;
-    if (this->shmem->n_clients == 0) {
+    bool quit_DES = this->shmem->n_clients == 0;
+    if (quit_DES && this->linger > 0 && this->start_linger_watchdog())
+      quit_DES = false;
+
+    if (quit_DES) {
       ret = release_shared_memory_mutex();
       if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) return ret;
 
@@ -292,6 +373,7 @@ SQLRETURN DBC::close() {
 #endif
   }
   this->connected = false;
+  release_pool_slot();
 
   return SQL_SUCCESS;
 }
@@ -305,6 +387,7 @@ DBC::~DBC()
 {
   if (this->connected)
       DBC::close();
+  release_pool_slot();
   if (env)
     env->remove_dbc(this);
 
@@ -512,6 +595,8 @@ SQLRETURN SQL_API DES_SQLAllocStmt(SQLHDBC hdbc, SQLHSTMT *phstmt)
 SQLRETURN SQL_API SQLFreeStmt(SQLHSTMT hstmt, SQLUSMALLINT fOption)
 {
   CHECK_HANDLE(hstmt);
+  /* DESODBC: the statement is locked by the worker while it is executed */
+  ((STMT *)hstmt)->finish_async();
   return DES_SQLFreeStmt(hstmt, fOption);
 }
 
@@ -116,18 +116,23 @@ DESGetInfo(SQLHDBC hdbc, SQLUSMALLINT fInfoType,
                       SQL_AT_DROP_TABLE_CONSTRAINT_CASCADE | SQL_AT_ADD_COLUMN |
                       SQL_AT_DROP_COLUMN | SQL_AT_DROP_COLUMN_CASCADE);
 
-  //This ODBC Driver does not allow asyncronic execution.
+  //Statements may be executed asynchronously (see AsyncWorker), but not
+  //connection functions.
 #ifndef USE_IODBC //I imagine iODBC does not allow 3.8, and that is why MyODBC put this #ifndef.
   case SQL_ASYNC_DBC_FUNCTIONS:
     MYINFO_SET_ULONG(SQL_ASYNC_DBC_NOT_CAPABLE);
 #endif
 
   case SQL_ASYNC_MODE:
-    MYINFO_SET_ULONG(SQL_AM_NONE);
+    MYINFO_SET_ULONG(SQL_AM_STATEMENT);
 
 #ifdef SQL_ASYNC_NOTIFICATION
   case SQL_ASYNC_NOTIFICATION:
+#ifdef SQL_ATTR_ASYNC_STMT_PCALLBACK
+    MYINFO_SET_ULONG(SQL_ASYNC_NOTIFICATION_CAPABLE);
+#else
     MYINFO_SET_ULONG(SQL_ASYNC_NOTIFICATION_NOT_CAPABLE);
+#endif
 #endif
 
   case SQL_BATCH_ROW_COUNT:
@@ -262,7 +267,7 @@ DESGetInfo(SQLHDBC hdbc, SQLUSMALLINT fInfoType,
           rc != SQL_SUCCESS_WITH_INFO) {
         return rc;
       }
-      std::string db = getLines(current_db_output)[0];
+      std::string db(getLines(current_db_output)[0]);
 
       MYINFO_SET_STR(string_to_char_pointer(db));
 
@@ -142,11 +142,17 @@ void STMT::reset_result_array() {
 }
 
 STMT::~STMT() {
+  // An asynchronous execution of the statement must not outlive it
+  if (async_result.valid()) async_result.wait();
+
   // Create a local mutex in the destructor.
   std::unique_lock<std::recursive_mutex> slock(lock);
 
   free_lengths();
 
+  if (row_stream) close_row_stream(row_stream);
+  if (streamed_table) free_result(streamed_table);
+
   reset_setpos_apd();
 
   LOCK_DBC(dbc);
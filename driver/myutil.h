@@ -194,7 +194,7 @@ bool is_in_string(const std::string &str, const std::string &search);
 /* DESODBC:
     Original author: DESODBC Developer
 */
-TypeAndLength get_Type_from_str(const std::string &str);
+TypeAndLength get_Type_from_str(std::string_view str);
 
 /* DESODBC:
     Original author: DESODBC Developer
@@ -229,13 +229,30 @@ wchar_t *string_to_wchar_pointer(const std::wstring &w_str);
 /* DESODBC:
     Original author: DESODBC Developer
 */
-std::vector<std::string> getLines(const std::string &str);
+std::vector<std::string_view> getLines(std::string_view str);
+
+/* DESODBC:
+    Original author: DESODBC Developer
+*/
+std::string_view trim_line_end(std::string_view line);
+
+/* DESODBC:
+    Original author: DESODBC Developer
+*/
+std::string_view unquote_tapi_value(std::string_view value);
 
 /* DESODBC:
     Original author: DESODBC Developer
 */
 std::vector<std::string> convertArrayNotationToStringVector(std::string str);
 
+#ifndef _WIN32
+/* DESODBC:
+    Original author: DESODBC Developer
+*/
+int wait_for_pipe_input(int fd, int timeout_ms);
+#endif
+
 /* DESODBC:
     This function sets possible errors
     given the TAPI output.
@@ -64,9 +64,9 @@ static SQLRETURN set_constmt_attr(SQLSMALLINT  HandleType,
     {
         case SQL_ATTR_ASYNC_ENABLE:
             if (ValuePtr == (SQLPOINTER) SQL_ASYNC_ENABLE_ON)
-            return set_handle_error(
-                HandleType, Handle, "01S02",
-                                        "Doesn't support asynchronous, changed to default");
+              options->async_enable= SQL_ASYNC_ENABLE_ON;
+            else
+              options->async_enable= SQL_ASYNC_ENABLE_OFF;
             break;
 
         case SQL_ATTR_CURSOR_SENSITIVITY:
@@ -131,6 +131,9 @@ static SQLRETURN set_constmt_attr(SQLSMALLINT  HandleType,
           break;
 
         case SQL_ATTR_QUERY_TIMEOUT:
+            options->query_timeout= (SQLULEN) ValuePtr;
+            break;
+
         case SQL_ATTR_KEYSET_SIZE:
         case SQL_ATTR_CONCURRENCY:
         case SQL_ATTR_NOSCAN:
@@ -161,7 +164,7 @@ get_constmt_attr(SQLSMALLINT  HandleType,
     switch (Attribute)
     {
         case SQL_ATTR_ASYNC_ENABLE:
-            *((SQLUINTEGER *) ValuePtr)= SQL_ASYNC_ENABLE_OFF;
+            *((SQLULEN *) ValuePtr)= options->async_enable;
             break;
 
         case SQL_ATTR_CURSOR_SENSITIVITY:
@@ -185,10 +188,7 @@ get_constmt_attr(SQLSMALLINT  HandleType,
             break;
 
         case SQL_ATTR_QUERY_TIMEOUT:
-          /* Do something only if the handle is STMT */
-          return set_handle_error(HandleType, Handle, "01S02",
-                                  "Unsupported option");
-          break;
+            *((SQLULEN *) ValuePtr)= options->query_timeout;
             break;
         case SQL_ATTR_RETRIEVE_DATA:
             *((SQLULEN *) ValuePtr)= (options->retrieve_data ? SQL_RD_ON : SQL_RD_OFF);
@@ -350,6 +350,11 @@ DESSetConnectAttr(SQLHDBC hdbc, SQLINTEGER Attribute,
         global_fido_callback = (fido_callback_func)ValuePtr;
         break;
       }
+    case DES_ATTR_SAVE_SNAPSHOT:
+      if (ValuePtr && StringLengthPtr >= 0)
+        return dbc->save_snapshot(
+            std::string((const char *)ValuePtr, StringLengthPtr));
+      return dbc->save_snapshot(ValuePtr ? (const char *)ValuePtr : "");
     case SQL_ATTR_ENLIST_IN_DTC:
         return dbc->set_error("HYC00",
                               "Unsupported option due to DES' characteristics");
@@ -475,6 +480,14 @@ DESGetConnectAttr(SQLHDBC hdbc, SQLINTEGER attrib, SQLCHAR **char_attr,
                           "Unsupported option due to DES' characteristics");
     break;
 
+  case DES_ATTR_CONNECT_TIME:
+    *((SQLUINTEGER *)num_attr) = dbc->connect_time_ms;
+    break;
+
+  case DES_ATTR_LAUNCH_TIME:
+    *((SQLUINTEGER *)num_attr) = dbc->launch_time_ms;
+    break;
+
   default:
     return set_handle_error(SQL_HANDLE_DBC, hdbc, "HY092", "Invalid attribute");
   }
@@ -662,6 +675,17 @@ DESSetStmtAttr(SQLHSTMT hstmt, SQLINTEGER Attribute, SQLPOINTER ValuePtr,
             options->simulateCursor= (SQLUINTEGER)(SQLULEN)ValuePtr;
             break;
 
+#ifdef SQL_ATTR_ASYNC_STMT_PCALLBACK
+        /* DESODBC: set by the driver manager for notification mode */
+        case SQL_ATTR_ASYNC_STMT_PCALLBACK:
+            stmt->async_callback= ValuePtr;
+            break;
+
+        case SQL_ATTR_ASYNC_STMT_PCONTEXT:
+            stmt->async_context= ValuePtr;
+            break;
+#endif
+
             /*
               3.x driver doesn't support any statement attributes
               at connection level, but to make sure all 2.x apps
@@ -899,6 +923,7 @@ SQLGetEnvAttr(SQLHENV    henv,
 SQLRETURN SQL_API
 SQLGetStmtOption(SQLHSTMT hstmt,SQLUSMALLINT option, SQLPOINTER param)
 {
+  CHECK_STMT_IDLE(hstmt);
   LOCK_STMT(hstmt);
 
   return DESGetStmtAttr(hstmt, option, param, SQL_NTS, (SQLINTEGER *)NULL);
@@ -908,6 +933,7 @@ SQLGetStmtOption(SQLHSTMT hstmt,SQLUSMALLINT option, SQLPOINTER param)
 SQLRETURN SQL_API
 SQLSetStmtOption(SQLHSTMT hstmt, SQLUSMALLINT option, SQLULEN param)
 {
+  CHECK_STMT_IDLE(hstmt);
   LOCK_STMT(hstmt);
 
   return DESSetStmtAttr(hstmt, option, (SQLPOINTER)param, SQL_NTS);
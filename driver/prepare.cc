@@ -261,6 +261,7 @@ SQLRETURN SQL_API SQLBindParameter( SQLHSTMT        hstmt,
                                     SQLLEN          cbValueMax,
                                     SQLLEN *        pcbValue )
 {
+  CHECK_STMT_IDLE(hstmt);
   LOCK_STMT(hstmt);
 
   return DES_SQLBindParameter(hstmt, ipar, fParamType, fCType, fSqlType,
@@ -289,7 +290,7 @@ SQLRETURN SQL_API SQLDescribeParam( SQLHSTMT        hstmt,
     STMT *stmt= (STMT *) hstmt;
 
     /* It is needed only in one case, but we won't make exceptions */
-    CHECK_HANDLE(hstmt);
+    CHECK_STMT_IDLE(hstmt);
 
     if (pfSqlType)
         *pfSqlType= SQL_VARCHAR;
@@ -327,7 +328,7 @@ SQLRETURN SQL_API SQLParamOptions( SQLHSTMT     hstmt,
   SQLRETURN rc;
   STMT *stmt= (STMT *)hstmt;
 
-  CHECK_HANDLE(hstmt);
+  CHECK_STMT_IDLE(hstmt);
 
   rc= DESSetStmtAttr(stmt, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)crow, 0);
   if (!SQL_SUCCEEDED(rc))
@@ -347,7 +348,7 @@ SQLRETURN SQL_API SQLNumParams(SQLHSTMT hstmt, SQLSMALLINT *pcpar)
 {
   STMT *stmt= (STMT *)hstmt;
 
-  CHECK_HANDLE(hstmt);
+  CHECK_STMT_IDLE(hstmt);
 
   if (pcpar)
     *pcpar= stmt->param_count;
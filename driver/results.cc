@@ -59,7 +59,14 @@ DES_RESULT::DES_RESULT() {
     Original author: DESODBC Developer
 */
 DES_RESULT::DES_RESULT(STMT *stmt) {
-  this->internal_table = new ResultTable(stmt);
+  if (stmt->streamed_table) {
+    // Already built while the output was being read
+    this->internal_table = stmt->streamed_table;
+    stmt->streamed_table = nullptr;
+    this->stream = stmt->row_stream;
+    stmt->row_stream = nullptr;
+  } else
+    this->internal_table = new ResultTable(stmt);
   if (!this->internal_table) throw std::bad_alloc();
 }
 
@@ -998,7 +1005,7 @@ SQLRETURN SQL_API SQLNumResultCols(SQLHSTMT  hstmt, SQLSMALLINT *pccol)
   SQLRETURN error;
   STMT *stmt= (STMT *) hstmt;
 
-  CHECK_HANDLE(hstmt);
+  CHECK_STMT_IDLE(hstmt);
   CHECK_DATA_OUTPUT(hstmt, pccol);
 
   if (stmt->param_count > 0 && stmt->dummy_state == ST_DUMMY_UNKNOWN &&
@@ -1285,6 +1292,7 @@ SQLRETURN SQL_API SQLBindCol(SQLHSTMT      StatementHandle,
                              SQLLEN        BufferLength,
                              SQLLEN *      StrLen_or_IndPtr)
 {
+  CHECK_STMT_IDLE(StatementHandle);
   SQLRETURN rc;
   STMT *stmt = (STMT *)StatementHandle;
   DESCREC *arrec;
@@ -1352,6 +1360,108 @@ SQLRETURN SQL_API SQLBindCol(SQLHSTMT      StatementHandle,
 
 }
 
+/* DESODBC:
+  Converter of a decoded cell (see Column::decode_value) into a bound
+  buffer. It returns the length to be stored in the length/indicator
+  buffer.
+
+  Original author: DESODBC Developer
+*/
+typedef SQLLEN (*typed_fetch_converter)(const Column &col, size_t row,
+                                        SQLPOINTER target);
+
+static SQLLEN typed_int_to_sshort(const Column &col, size_t row,
+                                  SQLPOINTER target) {
+  *((SQLSMALLINT *)target) = (SQLSMALLINT)(int)col.int_values[row];
+  return sizeof(SQLSMALLINT);
+}
+
+static SQLLEN typed_int_to_slong(const Column &col, size_t row,
+                                 SQLPOINTER target) {
+  *((SQLINTEGER *)target) = (SQLINTEGER)col.int_values[row];
+  return sizeof(SQLINTEGER);
+}
+
+static SQLLEN typed_int_to_sbigint(const Column &col, size_t row,
+                                   SQLPOINTER target) {
+  *((longlong *)target) = (longlong)col.int_values[row];
+  return sizeof(longlong);
+}
+
+static SQLLEN typed_int_to_double(const Column &col, size_t row,
+                                  SQLPOINTER target) {
+  *((double *)target) = (double)col.int_values[row];
+  return sizeof(double);
+}
+
+static SQLLEN typed_double_to_float(const Column &col, size_t row,
+                                    SQLPOINTER target) {
+  *((float *)target) = (float)col.double_values[row];
+  return sizeof(float);
+}
+
+static SQLLEN typed_double_to_double(const Column &col, size_t row,
+                                     SQLPOINTER target) {
+  *((double *)target) = col.double_values[row];
+  return sizeof(double);
+}
+
+static SQLLEN typed_ts_to_timestamp(const Column &col, size_t row,
+                                    SQLPOINTER target) {
+  memcpy(target, &col.ts_values[row], sizeof(SQL_TIMESTAMP_STRUCT));
+  return sizeof(SQL_TIMESTAMP_STRUCT);
+}
+
+/* DESODBC:
+  This function resolves the converter of the decoded cells of a column
+  of the result into the C type fCType, setting col to the column. It
+  returns nullptr if there is none, in which case the cells are converted
+  from their text.
+
+  Original author: DESODBC Developer
+*/
+static typed_fetch_converter resolve_typed_converter(STMT *stmt, uint column,
+                                                     SQLSMALLINT fCType,
+                                                     const Column **col)
+{
+  ResultTable *table= stmt->result ? stmt->result->internal_table : nullptr;
+  if (!table || stmt->fix_fields || column >= table->columns.size())
+    return nullptr;
+
+  *col= &table->columns[column];
+
+  switch ((*col)->typed_kind())
+  {
+  case Column::TYPED_INT:
+    switch (fCType)
+    {
+    case SQL_C_SHORT:
+    case SQL_C_SSHORT:    return typed_int_to_sshort;
+    case SQL_C_LONG:
+    case SQL_C_SLONG:     return typed_int_to_slong;
+    case SQL_C_SBIGINT:   return typed_int_to_sbigint;
+    case SQL_C_DOUBLE:    return typed_int_to_double;
+    default:              return nullptr;
+    }
+  case Column::TYPED_DOUBLE:
+    switch (fCType)
+    {
+    case SQL_C_FLOAT:     return typed_double_to_float;
+    case SQL_C_DOUBLE:    return typed_double_to_double;
+    default:              return nullptr;
+    }
+  case Column::TYPED_TIMESTAMP:
+    switch (fCType)
+    {
+    case SQL_C_TIMESTAMP:
+    case SQL_C_TYPE_TIMESTAMP: return typed_ts_to_timestamp;
+    default:              return nullptr;
+    }
+  default:
+    return nullptr;
+  }
+}
+
 /*
   @type    : ODBC 1.0 API
   @purpose : retrieves data for a single column in the result set. It can
@@ -1366,6 +1476,7 @@ SQLRETURN SQL_API SQLGetData(SQLHSTMT      StatementHandle,
                              SQLLEN        BufferLength,
                              SQLLEN *      StrLen_or_IndPtr)
 {
+  CHECK_STMT_IDLE(StatementHandle);
   STMT *stmt = (STMT *)StatementHandle;
   SQLRETURN result = SQL_SUCCESS;
   ulong length = 0;
@@ -1441,11 +1552,27 @@ SQLRETURN SQL_API SQLGetData(SQLHSTMT      StatementHandle,
   } else {
     /* catalog functions with "fake" results won't have lengths */
     length = irrec->row.datalen;
-    if (!length && stmt->current_values[sColNum])
+    if (!length && stmt->current_values[sColNum] && stmt->fix_fields)
       length = (ulong)strlen(stmt->current_values[sColNum]);
 
     arrec = desc_get_rec(stmt->ard, sColNum, FALSE);
 
+    /* Cells decoded when the result was built need no conversion */
+    const Column *col = nullptr;
+    size_t row = 0;
+    typed_fetch_converter typed =
+        TargetValuePtr
+            ? resolve_typed_converter(stmt, sColNum, TargetType, &col)
+            : nullptr;
+    if (typed && stmt->result->internal_table->cell_row(
+                     stmt->current_values, row) &&
+        col->is_decoded(row) &&
+        col->values[row] == stmt->current_values[sColNum]) {
+      SQLLEN written = typed(*col, row, TargetValuePtr);
+      if (StrLen_or_IndPtr) *StrLen_or_IndPtr = written;
+      return SQL_SUCCESS;
+    }
+
     /* String will be used as a temporary storage which frees itself
      * automatically */
     std::string temp_str;
@@ -1471,6 +1598,7 @@ SQLRETURN SQL_API SQLGetData(SQLHSTMT      StatementHandle,
 */
 SQLRETURN SQL_API SQLMoreResults( SQLHSTMT hstmt )
 {
+  CHECK_STMT_IDLE(hstmt);
   STMT *stmt = (STMT *)hstmt;
   int nRetVal = 0;
   SQLRETURN nReturn = SQL_SUCCESS;
@@ -1550,7 +1678,7 @@ SQLRETURN SQL_API SQLRowCount( SQLHSTMT hstmt,
 {
     STMT *stmt= (STMT *) hstmt;
 
-    CHECK_HANDLE(hstmt);
+    CHECK_STMT_IDLE(hstmt);
     CHECK_DATA_OUTPUT(hstmt, pcrow);
 
     if ( stmt->result )
@@ -1667,81 +1795,265 @@ fill_fetch_bookmark_buffers(STMT *stmt, ulong value, uint rownum)
 }
 
 
+/* DESODBC:
+  Converter of a non-NULL value into a bound buffer of a fixed-size C
+  type. It returns the length to be stored in the length/indicator buffer.
+  Each one does exactly what sql_get_data does for its C type.
+
+  Original author: DESODBC Developer
+*/
+typedef SQLLEN (*fetch_converter)(char *value, ulong length,
+                                  SQLPOINTER target);
+
+/* DESODBC:
+  A bound column, along with the converters resolved for it (nullptr if it
+  has to go through sql_get_data).
+
+  Original author: DESODBC Developer
+*/
+struct FetchBinding {
+  uint column;
+  DESCREC *irrec;
+  DESCREC *arrec;
+  fetch_converter convert;
+  typed_fetch_converter typed;
+  const Column *typed_column;
+};
+
+static SQLLEN convert_bit(char *value, ulong, SQLPOINTER target) {
+  *((char *)target) = (int)strtol(value, NULL, 10) > 0 ? '\1' : '\0';
+  return 1;
+}
+
+static SQLLEN convert_stinyint(char *value, ulong, SQLPOINTER target) {
+  *((SQLSCHAR *)target) = (SQLSCHAR)(int)strtol(value, NULL, 10);
+  return 1;
+}
+
+static SQLLEN convert_utinyint(char *value, ulong, SQLPOINTER target) {
+  *((SQLCHAR *)target) = (SQLCHAR)(unsigned int)strtoul(value, NULL, 10);
+  return 1;
+}
+
+static SQLLEN convert_sshort(char *value, ulong, SQLPOINTER target) {
+  *((SQLSMALLINT *)target) = (SQLSMALLINT)(int)strtol(value, NULL, 10);
+  return sizeof(SQLSMALLINT);
+}
+
+static SQLLEN convert_ushort(char *value, ulong, SQLPOINTER target) {
+  *((SQLUSMALLINT *)target) =
+      (SQLUSMALLINT)(unsigned int)strtoul(value, NULL, 10);
+  return sizeof(SQLUSMALLINT);
+}
+
+static SQLLEN convert_slong(char *value, ulong length, SQLPOINTER target) {
+  /* Check if it could be a date, as sql_get_data does */
+  if (length >= 10 && value[4] == '-' && value[7] == '-' &&
+      (!value[10] || value[10] == ' '))
+    *((SQLINTEGER *)target) = ((SQLINTEGER)atol(value) * 10000L +
+                               (SQLINTEGER)atol(value + 5) * 100L +
+                               (SQLINTEGER)atol(value + 8));
+  else
+    *((SQLINTEGER *)target) = (SQLINTEGER)strtoll(value, NULL, 10);
+  return sizeof(SQLINTEGER);
+}
+
+static SQLLEN convert_ulong(char *value, ulong, SQLPOINTER target) {
+  *((SQLUINTEGER *)target) = (SQLUINTEGER)strtoull(value, NULL, 10);
+  return sizeof(SQLUINTEGER);
+}
+
+static SQLLEN convert_sbigint(char *value, ulong, SQLPOINTER target) {
+  *((longlong *)target) = (longlong)strtoll(value, NULL, 10);
+  return sizeof(longlong);
+}
+
+static SQLLEN convert_ubigint(char *value, ulong, SQLPOINTER target) {
+  *((ulonglong *)target) = (ulonglong)strtoull(value, NULL, 10);
+  return sizeof(ulonglong);
+}
+
+static SQLLEN convert_float(char *value, ulong length, SQLPOINTER target) {
+  *((float *)target) = (float)myodbc_strtod(value, length);
+  return sizeof(float);
+}
+
+static SQLLEN convert_double(char *value, ulong length, SQLPOINTER target) {
+  *((double *)target) = (double)myodbc_strtod(value, length);
+  return sizeof(double);
+}
+
+/* DESODBC:
+  This function resolves the converter of a bound column. Character,
+  binary, temporal and numeric-struct targets, as well as conversions that
+  are not supported (whose error is reported by sql_get_data), keep going
+  through sql_get_data.
+
+  Original author: DESODBC Developer
+*/
+static fetch_converter resolve_fetch_converter(STMT *stmt, uint column,
+                                               DESCREC *arrec)
+{
+  if (!arrec->data_ptr)
+    return nullptr;
+
+  DES_FIELD *field= des_fetch_field_direct(stmt->result, column);
+  SQLSMALLINT fCType= arrec->concise_type;
+
+  if (!odbc_supported_conversion(get_sql_data_type(stmt, field, 0), fCType)
+   && !driver_supported_conversion(field, fCType))
+    return nullptr;
+
+  switch (fCType)
+  {
+  case SQL_C_BIT:       return convert_bit;
+  case SQL_C_TINYINT:
+  case SQL_C_STINYINT:  return convert_stinyint;
+  case SQL_C_UTINYINT:  return convert_utinyint;
+  case SQL_C_SHORT:
+  case SQL_C_SSHORT:    return convert_sshort;
+  case SQL_C_USHORT:    return convert_ushort;
+  case SQL_C_LONG:
+  case SQL_C_SLONG:     return convert_slong;
+  case SQL_C_ULONG:     return convert_ulong;
+  case SQL_C_SBIGINT:   return convert_sbigint;
+  case SQL_C_UBIGINT:   return convert_ubigint;
+  case SQL_C_FLOAT:     return convert_float;
+  case SQL_C_DOUBLE:    return convert_double;
+  default:              return nullptr;
+  }
+}
+
+/* DESODBC:
+  This function resolves how every bound column is filled. None of it
+  changes between the rows of a fetch, so it is done once per fetch
+  instead of once per cell.
+
+  Original author: DESODBC Developer
+*/
+static std::vector<FetchBinding> resolve_fetch_bindings(STMT *stmt)
+{
+  std::vector<FetchBinding> bindings;
+  uint count= (uint)desodbc_min(stmt->ird->rcount(), stmt->ard->rcount());
+
+  for (uint i= 0; i < count; ++i)
+  {
+    DESCREC *irrec= desc_get_rec(stmt->ird, i, FALSE);
+    DESCREC *arrec= desc_get_rec(stmt->ard, i, FALSE);
+    assert(irrec && arrec);
+
+    if (ARD_IS_BOUND(arrec))
+    {
+      FetchBinding binding= {i, irrec, arrec,
+                             resolve_fetch_converter(stmt, i, arrec),
+                             nullptr, nullptr};
+      if (arrec->data_ptr)
+        binding.typed= resolve_typed_converter(stmt, i, arrec->concise_type,
+                                               &binding.typed_column);
+      bindings.push_back(binding);
+    }
+  }
+
+  return bindings;
+}
+
+
 /**
   Populate a single row of fetch buffers
 
   @param[in]  stmt        Handle of statement
   @param[in]  values      Row buffers from libmysql
   @param[in]  rownum      Row number of current fetch block
+  @param[in]  bindings    Bound columns (see resolve_fetch_bindings)
 */
 static SQLRETURN
-fill_fetch_buffers(STMT *stmt, DES_ROW values, uint rownum)
+fill_fetch_buffers(STMT *stmt, DES_ROW values, uint rownum,
+                   const std::vector<FetchBinding> &bindings)
 {
   SQLRETURN res= SQL_SUCCESS, tmp_res;
-  int i;
   ulong length= 0;
-  DESCREC *irrec, *arrec;
 
-  for (i= 0; i < desodbc_min(stmt->ird->rcount(), stmt->ard->rcount()); ++i, ++values)
+  /* Row of the result table, to take the cells it has decoded */
+  size_t table_row= 0;
+  bool typed_row= stmt->result && stmt->result->internal_table &&
+                  stmt->result->internal_table->cell_row(values, table_row);
+
+  for (const FetchBinding &binding : bindings)
   {
-    irrec= desc_get_rec(stmt->ird, i, FALSE);
-    arrec= desc_get_rec(stmt->ard, i, FALSE);
-    assert(irrec && arrec);
+    uint i= binding.column;
+    DESCREC *irrec= binding.irrec, *arrec= binding.arrec;
+    char *value= values[i];
+    SQLLEN *pcbValue= NULL;
+    SQLPOINTER TargetValuePtr= NULL;
 
-    if (ARD_IS_BOUND(arrec))
+    if (arrec->data_ptr)
     {
-      SQLLEN *pcbValue= NULL;
-      SQLPOINTER TargetValuePtr= NULL;
+      TargetValuePtr= ptr_offset_adjust(arrec->data_ptr,
+                                        stmt->ard->bind_offset_ptr,
+                                        stmt->ard->bind_type,
+                                        (SQLINTEGER)arrec->octet_length, rownum);
+    }
 
-      stmt->reset_getdata_position();
+    /* catalog functions with "fake" results won't have lengths */
+    length= irrec->row.datalen;
 
-      if (arrec->data_ptr)
-      {
-        TargetValuePtr= ptr_offset_adjust(arrec->data_ptr,
-                                          stmt->ard->bind_offset_ptr,
-                                          stmt->ard->bind_type,
-                                          (SQLINTEGER)arrec->octet_length, rownum);
-      }
+    if (!length && value && stmt->fix_fields)
+    {
+      length = (ulong)strlen(value);
+    }
 
-      /* catalog functions with "fake" results won't have lengths */
-      length= irrec->row.datalen;
+    /* We need to pass that pointer to the sql_get_data so it could detect
+       22002 error - for NULL values that pointer has to be supplied by user.
+     */
+    if (arrec->octet_length_ptr)
+    {
+      pcbValue= (SQLLEN*)ptr_offset_adjust(arrec->octet_length_ptr,
+                                    stmt->ard->bind_offset_ptr,
+                                    stmt->ard->bind_type,
+                                    sizeof(SQLLEN), rownum);
+    }
 
-      if (!length && *values)
-      {
-        length = (ulong)strlen(*values);
-      }
+    if (typed_row && binding.typed &&
+        binding.typed_column->is_decoded(table_row) &&
+        binding.typed_column->values[table_row] == value)
+    {
+      SQLLEN written= binding.typed(*binding.typed_column, table_row,
+                                    TargetValuePtr);
+      if (pcbValue)
+        *pcbValue= written;
+      continue;
+    }
 
-      /* We need to pass that pointer to the sql_get_data so it could detect
-         22002 error - for NULL values that pointer has to be supplied by user.
-       */
-      if (arrec->octet_length_ptr)
-      {
-        pcbValue= (SQLLEN*)ptr_offset_adjust(arrec->octet_length_ptr,
-                                      stmt->ard->bind_offset_ptr,
-                                      stmt->ard->bind_type,
-                                      sizeof(SQLLEN), rownum);
-      }
+    /* NULL values are left to sql_get_data */
+    if (binding.convert && value)
+    {
+      SQLLEN written= binding.convert(value, length, TargetValuePtr);
+      if (pcbValue)
+        *pcbValue= written;
+      continue;
+    }
+
+    stmt->reset_getdata_position();
 
-      std::string temp_str;
-      char *temp_val = fix_padding(stmt, arrec->concise_type, *values,
-                                   temp_str, arrec->octet_length,
-                                   length, irrec);
+    std::string temp_str;
+    char *temp_val = fix_padding(stmt, arrec->concise_type, value,
+                                 temp_str, arrec->octet_length,
+                                 length, irrec);
 
-      tmp_res= sql_get_data(stmt, arrec->concise_type, (uint)i,
-                            TargetValuePtr, arrec->octet_length, pcbValue,
-                            temp_val, length, arrec);
+    tmp_res= sql_get_data(stmt, arrec->concise_type, i,
+                          TargetValuePtr, arrec->octet_length, pcbValue,
+                          temp_val, length, arrec);
 
-      if (tmp_res != SQL_SUCCESS)
+    if (tmp_res != SQL_SUCCESS)
+    {
+      if (tmp_res == SQL_SUCCESS_WITH_INFO)
       {
-        if (tmp_res == SQL_SUCCESS_WITH_INFO)
-        {
-          if (res == SQL_SUCCESS)
-            res= tmp_res;
-        }
-        else
-        {
-          res= SQL_ERROR;
-        }
+        if (res == SQL_SUCCESS)
+          res= tmp_res;
+      }
+      else
+      {
+        res= SQL_ERROR;
       }
     }
   }
@@ -1939,7 +2251,8 @@ SQLRETURN SQL_API myodbc_single_fetch( SQLHSTMT             hstmt,
                               stmt->result->field_count);
     }
 
-    row_res= fill_fetch_buffers(stmt, values, cur_row);
+    row_res= fill_fetch_buffers(stmt, values, cur_row,
+                                resolve_fetch_bindings(stmt));
 
     /* For SQL_SUCCESS we need all rows to be SQL_SUCCESS */
     if (res != row_res)
@@ -2083,7 +2396,9 @@ SQLRETURN SQL_API DES_SQLExtendedFetch( SQLHSTMT             hstmt,
 
     if ( stmt->stmt_options.cursor_type == SQL_CURSOR_FORWARD_ONLY )
     {
-        if ( fFetchType != SQL_FETCH_NEXT && !stmt->dbc->ds.opt_SAFE )
+        /* DESODBC: a streamed answer can only be read forward */
+        if ( fFetchType != SQL_FETCH_NEXT &&
+             (!stmt->dbc->ds.opt_SAFE || stmt->result->stream) )
         {
         res = stmt->set_error("HY106",
                 "Wrong fetchtype with FORWARD ONLY cursor");
@@ -2094,6 +2409,17 @@ SQLRETURN SQL_API DES_SQLExtendedFetch( SQLHSTMT             hstmt,
     if ( !pcrow )
         pcrow= &dummy_pcrow;
 
+    /* DESODBC: rows of a streamed answer are read as the rowsets need them */
+    if (stmt->result->stream)
+    {
+        res = des_read_stream(stmt->result, stmt->ard->array_size);
+        if (!SQL_SUCCEEDED(res))
+        {
+        stmt->error = stmt->dbc->error;
+        throw stmt->error;
+        }
+    }
+
     /* for scrollable cursor("scroller") max_row is max row for currently
         fetched part of resultset */
     max_row= (long) num_rows(stmt);
@@ -2122,6 +2448,9 @@ SQLRETURN SQL_API DES_SQLExtendedFetch( SQLHSTMT             hstmt,
         }
     }
 
+    /* Bound columns are resolved once for the whole block */
+    std::vector<FetchBinding> bindings= resolve_fetch_bindings(stmt);
+
     res= SQL_SUCCESS;
     for (i= 0 ; i < rows_to_fetch ; ++i)
     {
@@ -2190,7 +2519,7 @@ SQLRETURN SQL_API DES_SQLExtendedFetch( SQLHSTMT             hstmt,
         {
         row_book= fill_fetch_bookmark_buffers(stmt, (ulong)(irow + i + 1), (uint)i);
         }
-        row_res= fill_fetch_buffers(stmt, values, (uint)i);
+        row_res= fill_fetch_buffers(stmt, values, (uint)i, bindings);
 
         /* For SQL_SUCCESS we need all rows to be SQL_SUCCESS */
         if (res != row_res || res != row_book)
@@ -2295,6 +2624,7 @@ SQLRETURN SQL_API SQLExtendedFetch( SQLHSTMT        hstmt,
                                     SQLULEN        *pcrow,
                                     SQLUSMALLINT   *rgfRowStatus )
 {
+    CHECK_STMT_IDLE(hstmt);
     SQLRETURN rc;
     SQLULEN rows= 0;
     STMT_OPTIONS *options;
@@ -2323,6 +2653,7 @@ SQLRETURN SQL_API SQLFetchScroll( SQLHSTMT      StatementHandle,
                                   SQLSMALLINT   FetchOrientation,
                                   SQLLEN        FetchOffset )
 {
+    CHECK_STMT_IDLE(StatementHandle);
     STMT *stmt = (STMT *)StatementHandle;
     STMT_OPTIONS *options;
 
@@ -2359,6 +2690,7 @@ SQLRETURN SQL_API SQLFetchScroll( SQLHSTMT      StatementHandle,
 */
 
 SQLRETURN SQL_API SQLFetch(SQLHSTMT StatementHandle) {
+  CHECK_STMT_IDLE(StatementHandle);
   STMT *stmt = (STMT *)StatementHandle;
   STMT_OPTIONS *options;
 
@@ -2381,8 +2713,8 @@ size_t ResultTable::col_count() { return names_ordered.size(); }
     Original author: DESODBC Developer
 */
 size_t ResultTable::row_count() {
-  if (names_ordered.size() != 0)
-    return columns[names_ordered[0]].values.size();
+  if (!columns.empty())
+    return columns[0].values.size();
   else
     return 0;
 }
@@ -2395,8 +2727,7 @@ void ResultTable::insert_col(const std::string &tableName,
                              const TypeAndLength &columnType,
                              const SQLSMALLINT &columnNullable) {
   names_ordered.push_back(columnName);
-  columns[columnName] =
-      Column(tableName, columnName, columnType, columnNullable);
+  columns.push_back(Column(tableName, columnName, columnType, columnNullable));
 }
 
 /* DESODBC:
@@ -2405,14 +2736,54 @@ void ResultTable::insert_col(const std::string &tableName,
 void ResultTable::insert_col(DES_FIELD *field) {
   std::string name = field->name;
   names_ordered.push_back(name);
-  columns[name] = Column(field);
+  columns.push_back(Column(field));
+}
+
+/* DESODBC:
+    Original author: DESODBC Developer
+*/
+size_t ResultTable::col_index(const std::string &columnName) {
+  for (size_t i = 0; i < names_ordered.size(); ++i)
+    if (names_ordered[i] == columnName) return i;
+  throw std::out_of_range("No column " + columnName + " in result");
+}
+
+/* DESODBC:
+    Original author: DESODBC Developer
+*/
+Column &ResultTable::column(const std::string &columnName) {
+  return columns[col_index(columnName)];
+}
+
+/* DESODBC:
+    Copies a value into the arena of the table, followed by a '\0'.
+    Original author: DESODBC Developer
+*/
+char *ResultTable::store_value(const char *value, size_t length) {
+  char *cell = (char *)arena.Alloc(length + 1);
+  if (!cell) throw std::bad_alloc();
+  memcpy(cell, value, length);
+  cell[length] = '\0';
+  return cell;
+}
+
+/* DESODBC:
+    Appends a value (nullptr for NULL) to the column with the given
+    ordinal.
+    Original author: DESODBC Developer
+*/
+void ResultTable::insert_value(size_t col, const char *value, size_t length) {
+  if (value)
+    columns[col].insert_value(store_value(value, length), length);
+  else
+    columns[col].insert_value(nullptr, 0);
 }
 
 /* DESODBC:
     Original author: DESODBC Developer
 */
 void ResultTable::insert_value(const std::string &columnName, char *value) {
-  columns[columnName].insert_value(value);
+  insert_value(col_index(columnName), value, value ? strlen(value) : 0);
 }
 
 /* DESODBC:
@@ -2420,94 +2791,185 @@ void ResultTable::insert_value(const std::string &columnName, char *value) {
 */
 void ResultTable::insert_value(const std::string &columnName,
                                const std::string &value) {
-  columns[columnName].insert_value(string_to_char_pointer(value));
+  insert_value(col_index(columnName), value.data(), value.size());
 }
 
 /* DESODBC:
     Original author: DESODBC Developer
 */
 unsigned long Column::getLength(int row) {
-  if (!values.empty() && values[row])
-    return strlen(values[row]);
+  if (row >= 0 && row < lengths.size())
+    return lengths[row];
   else
     return 0;
 }
 
 /* DESODBC:
+    Updates the statistics of the column with a value that is being
+    inserted into it.
+
     Original author: DESODBC Developer
 */
-unsigned int Column::getDecimals() {
-  if (this->field->type == DES_TYPE_FLOAT ||
-      this->field->type == DES_TYPE_REAL) {
-    unsigned int max_decimals = 0;
-    for (auto value : values) {
-      std::string val_str(value);
-      size_t pos = val_str.find('.');
-      if (pos != std::string::npos) {
-        unsigned int decimals =
-            val_str.substr(pos + 1, val_str.size() - (pos + 1)).size();
-        if (decimals > max_decimals)
-            max_decimals = decimals;
-      }
-    }
+void Column::account_value(const char *value, unsigned long length) {
+  if (!value) return;
 
-    return max_decimals;
+  if (length > max_value_length) max_value_length = length;
 
-  } else
-    return 0;
+  if (field &&
+      (field->type == DES_TYPE_FLOAT || field->type == DES_TYPE_REAL)) {
+    const char *point = (const char *)memchr(value, '.', length);
+    if (point) {
+      unsigned int decimals = (unsigned int)(value + length - (point + 1));
+      if (decimals > max_decimals) max_decimals = decimals;
+    }
+  }
 }
 
 /* DESODBC:
     Original author: DESODBC Developer
 */
-unsigned int Column::getColumnSize() {
-  if (type.len == 0)
-    return get_type_size(type.simple_type);
-  else
-    return type.len;
-
+Column::TypedKind Column::typed_kind() const {
+  if (!field) return TYPED_NONE;
+
+  switch (field->type) {
+    case DES_TYPE_INT:
+    case DES_TYPE_INTEGER:
+    case DES_TYPE_TINY:
+    case DES_TYPE_SHORT:
+    case DES_TYPE_LONG:
+      return TYPED_INT;
+    case DES_TYPE_FLOAT:
+    case DES_TYPE_REAL:
+      return TYPED_DOUBLE;
+    case DES_TYPE_DATE:
+    case DES_TYPE_DATETIME:
+    case DES_TYPE_TIMESTAMP:
+      return TYPED_TIMESTAMP;
+    default:
+      return TYPED_NONE;
+  }
 }
 
 /* DESODBC:
+    Decodes the cell of the given row into the native storage of the
+    column, which must already hold that row. Integers only count as
+    decoded if the whole text is one, and temporal values if str_to_ts
+    takes them as they are, so that a fetch of a decoded cell gives
+    exactly what converting its text would.
+
     Original author: DESODBC Developer
 */
-unsigned int Column::getMaxLength() {
-  unsigned int max = 0;
+void Column::decode_value(size_t row) {
+  TypedKind kind = typed_kind();
+  if (kind == TYPED_NONE || row >= decoded.size()) return;
+
+  const char *value = values[row];
+  bool ok = false;
+  if (value && lengths[row] > 0) {
+    switch (kind) {
+      case TYPED_INT: {
+        char *end;
+        errno = 0;
+        int_values[row] = strtoll(value, &end, 10);
+        ok = *end == '\0' && errno == 0;
+        break;
+      }
+      case TYPED_DOUBLE:
+        double_values[row] = myodbc_strtod(value, lengths[row]);
+        ok = true;
+        break;
+      default:
+        ok = str_to_ts(&ts_values[row], value, SQL_NTS, FALSE, TRUE) == 0;
+    }
+  }
+  decoded[row] = ok;
+}
+
+/* DESODBC:
+    Decodes the cells from the given row on. Numbers go through the batch
+    parsers first; the cells they leave, and temporal values, are decoded
+    one by one.
 
-  for (auto value : values) {
-    if (value && strlen(value) > max) max = strlen(value);
+    Original author: DESODBC Developer
+*/
+void Column::decode_rows(size_t first) {
+  TypedKind kind = typed_kind();
+  size_t count = values.size();
+  if (kind == TYPED_NONE || first >= count) return;
+
+  std::vector<char> converted(count - first, 0);
+  decoded.resize(count);
+  switch (kind) {
+    case TYPED_INT:
+      int_values.resize(count);
+      myodbc_strtoll_batch(values.data() + first, lengths.data() + first,
+                           count - first, int_values.data() + first,
+                           converted.data());
+      break;
+    case TYPED_DOUBLE:
+      double_values.resize(count);
+      myodbc_strtod_batch(values.data() + first, lengths.data() + first,
+                          count - first, double_values.data() + first,
+                          converted.data());
+      break;
+    default:
+      ts_values.resize(count);
   }
 
-  SQLULEN type_size = this->get_simple_type();
-  if (max > this->type.len)
-    return max;
-  else
-    return this->type.len;
+  for (size_t row = first; row < count; ++row) {
+    if (converted[row - first])
+      decoded[row] = true;
+    else
+      decode_value(row);
+  }
 }
 
 /* DESODBC:
     Original author: DESODBC Developer
 */
-DES_ROWS * Column::generate_DES_ROWS(int current_row) {
-  DES_ROWS *rows = new DES_ROWS;
-  if (!rows) throw std::bad_alloc();
+void Column::erase_typed_rows(size_t first, size_t last) {
+  if (last > decoded.size()) last = decoded.size();
+  if (first >= last) return;
+  decoded.erase(decoded.begin() + first, decoded.begin() + last);
+  if (!int_values.empty())
+    int_values.erase(int_values.begin() + first, int_values.begin() + last);
+  if (!double_values.empty())
+    double_values.erase(double_values.begin() + first,
+                        double_values.begin() + last);
+  if (!ts_values.empty())
+    ts_values.erase(ts_values.begin() + first, ts_values.begin() + last);
+}
 
-  DES_ROWS *ptr = rows;
-  for (int i = 0; current_row + i < values.size(); ++i) {
-    ptr->data = new char *;
-    if (!ptr->data) throw std::bad_alloc();
+/* DESODBC:
+    Original author: DESODBC Developer
+*/
+unsigned int Column::getDecimals() {
+  if (this->field->type == DES_TYPE_FLOAT ||
+      this->field->type == DES_TYPE_REAL)
+    return max_decimals;
+  else
+    return 0;
+}
 
-    *(ptr->data) = values[current_row + i];
+/* DESODBC:
+    Original author: DESODBC Developer
+*/
+unsigned int Column::getColumnSize() {
+  if (type.len == 0)
+    return get_type_size(type.simple_type);
+  else
+    return type.len;
 
-    if (current_row + (i + 1) < values.size()) {
-      ptr->next = new DES_ROWS;
-      if (!ptr->next) throw std::bad_alloc();
+}
 
-      ptr = ptr->next;
-    } else
-      ptr->next = nullptr;
-  }
-  return rows;
+/* DESODBC:
+    Original author: DESODBC Developer
+*/
+unsigned int Column::getMaxLength() {
+  if (max_value_length > this->type.len)
+    return max_value_length;
+  else
+    return this->type.len;
 }
 
 /* DESODBC:
@@ -2580,9 +3042,14 @@ Column::Column(const std::string &table_name, const std::string &col_name,
 /* DESODBC:
     Original author: DESODBC Developer
 */
-void Column::update_row(const int row_index, char *value) {
-  if (values[row_index]) delete values[row_index];
+void Column::update_row(const int row_index, char *value,
+                        unsigned long length) {
+  // The previous value stays in the arena until the table is freed
   values[row_index] = value;
+  lengths[row_index] = length;
+  account_value(value, length);
+  // Rows not decoded yet will be when the table is indexed
+  if ((size_t)row_index < decoded.size()) decode_value(row_index);
 }
 
 /* DESODBC:
@@ -2590,6 +3057,8 @@ void Column::update_row(const int row_index, char *value) {
 */
 void Column::remove_row(const int row_index) {
   values.erase(values.begin() + row_index);
+  lengths.erase(lengths.begin() + row_index);
+  erase_typed_rows(row_index, row_index + 1);
 }
 
 /* DESODBC:
@@ -2604,88 +3073,112 @@ SQLSMALLINT Column::get_decimal_digits() {
 }
 
 /* DESODBC:
+    Removes (and frees) the first n rows of the table.
     Original author: DESODBC Developer
 */
-unsigned long *ResultTable::fetch_lengths(int current_row) {
-  unsigned long *lengths =
-      (unsigned long *)malloc(names_ordered.size() * sizeof(unsigned long));
-
-  if (!lengths) {
-    throw std::bad_alloc();
+void ResultTable::remove_first_rows(size_t n) {
+  if (n >= row_count()) {
+    for (Column &col : columns) {
+      col.values.clear();
+      col.lengths.clear();
+      col.erase_typed_rows(0, col.decoded.size());
+    }
+    arena.ClearForReuse();
+    return;
   }
 
-  for (int i = 0; i < names_ordered.size(); ++i) {
-    unsigned long *length = lengths + i;
-    *length = columns[names_ordered[i]].getLength(current_row);
+  // The remaining cells are moved to a new arena, so that the old one can
+  // be freed.
+  desodbc::MEM_ROOT old_arena(std::move(arena));
+  arena = desodbc::MEM_ROOT(PSI_NOT_INSTRUMENTED, RESULT_ARENA_BLOCK_SIZE);
+  for (Column &col : columns) {
+    col.values.erase(col.values.begin(), col.values.begin() + n);
+    col.lengths.erase(col.lengths.begin(), col.lengths.begin() + n);
+    col.erase_typed_rows(0, n);
+    for (size_t i = 0; i < col.values.size(); ++i)
+      if (col.values[i])
+        col.values[i] = store_value(col.values[i], col.lengths[i]);
   }
-
-  return lengths;
 }
 
 /* DESODBC:
+    This function writes the cells of every row of the table, one row
+    after the other, into cells, and their lengths into lengths. Both
+    must hold row_count() * col_count() elements. The cells point into
+    the arena of the table.
+
     Original author: DESODBC Developer
 */
-DES_ROW ResultTable::generate_DES_ROW(const int index) {
-  int n_cols = names_ordered.size();
-  DES_ROW row = new char *[n_cols];
+void ResultTable::fill_row_index(char **cells, unsigned long *lengths) {
+  size_t n_cols = columns.size();
+  size_t n_rows = row_count();
 
-  if (!row)
-    throw std::bad_alloc();
+  // Rows are indexed only once every cell of theirs has been decoded
+  for (Column &col : columns) col.decode_rows(col.decoded.size());
 
-  for (int i = 0; i < n_cols; ++i) {
-    row[i] = columns[names_ordered[i]].values[index];
-  }
+  indexed_cells = cells;
+  indexed_rows = n_rows;
 
-  return row;
+  for (size_t j = 0; j < n_cols; ++j) {
+    const Column &col = columns[j];
+    for (size_t i = 0; i < n_rows; ++i) {
+      cells[i * n_cols + j] = col.values[i];
+      lengths[i * n_cols + j] = col.lengths[i];
+    }
+  }
 }
 
 /* DESODBC:
+    This function finds the row of the table whose cells a fetch handed
+    out as row_cells. It returns false if they do not come from the last
+    row index of the table (e.g. for rows rebuilt by fix_fields).
+
     Original author: DESODBC Developer
 */
-DES_ROWS *ResultTable::generate_DES_ROWS(const int current_row) {
-  DES_ROWS *rows = new DES_ROWS;
-  if (!rows) throw std::bad_alloc();
+bool ResultTable::cell_row(DES_ROW row_cells, size_t &row) {
+  size_t n_cols = columns.size();
+  if (!indexed_cells || !n_cols) return false;
 
-  rows->data = nullptr;
-  rows->next = nullptr;
+  uintptr_t begin = (uintptr_t)indexed_cells;
+  uintptr_t cell = (uintptr_t)row_cells;
+  if (cell < begin) return false;
 
-  DES_ROWS *ptr = rows;
-  int n_rows =
-      columns[names_ordered[0]].values.size(); //there will always be a column (the metadata ones)
+  size_t offset = (cell - begin) / sizeof(char *);
+  if (offset % n_cols || offset / n_cols >= indexed_rows) return false;
 
-  for (int i = 0; current_row + i < n_rows; ++i) {
-    ptr->data = generate_DES_ROW(current_row + i);
+  row = offset / n_cols;
+  return row < row_count();
+}
 
-    if (current_row + (i + 1) < n_rows) {
-      ptr->next = new DES_ROWS;
-      if (!ptr->next) throw std::bad_alloc();
+/* DESODBC:
+    Original author: DESODBC Developer
+*/
+void ResultTable::generate_row_index(DES_DATA *data) {
+  size_t n_cells = row_count() * col_count();
+  if (!n_cells) n_cells = 1;
 
-      ptr = ptr->next;
-    } else
-      ptr->next = nullptr;
+  data->cells = new char *[n_cells];
+  data->lengths = new unsigned long[n_cells];
 
-    // length doesn't seem to be modified, as I have verified debugging MySQL
-    // ODBC.
-  }
-  return rows;
+  fill_row_index(data->cells, data->lengths);
 }
 
 /* DESODBC:
     Original author: DESODBC Developer
 */
 DES_FIELD* ResultTable::get_DES_FIELD(int col_index) {
-  return columns[names_ordered[col_index]].get_DES_FIELD();
+  return columns[col_index].get_DES_FIELD();
 }
 
 /* DESODBC:
     Original author: DESODBC Developer
 */
 std::vector<ForeignKeyInfo> ResultTable::get_foreign_keys_from_TAPI(
-    const std::vector<std::string> &lines, int &index) {
+    const std::vector<std::string_view> &lines, int &index) {
   std::vector<ForeignKeyInfo> result;
 
   while (lines[index] != "$") {
-    std::string str = lines[index];
+    std::string str(lines[index]);
 
     // We erase these brackets for easer the parsing
     str.erase(std::remove(str.begin(), str.end(), '['), str.end());
@@ -2729,7 +3222,7 @@ std::vector<ForeignKeyInfo> ResultTable::get_foreign_keys_from_TAPI(
     Original author: DESODBC Developer
 */
 DBSchemaRelationInfo ResultTable::get_relation_info(
-    const std::vector<std::string> &lines,
+    const std::vector<std::string_view> &lines,
                                int &index) {
   // We asume that the first given line by index is "$table" or "$view".
   // Leaves the index to the position when all we are
@@ -2743,13 +3236,13 @@ DBSchemaRelationInfo ResultTable::get_relation_info(
 
     index++;
 
-    std::string relation_name = lines[index];
+    std::string relation_name(lines[index]);
     relation_info.name = relation_name;
 
     index++;
     int col_index = 1;
     while (index < lines.size() && lines[index] != "$") {
-      std::string column_name = lines[index];
+      std::string column_name(lines[index]);
       TypeAndLength type = get_Type_from_str(lines[index + 1]);
 
       relation_info.columns_index_map.insert({column_name, col_index});
@@ -2791,7 +3284,7 @@ DBSchemaRelationInfo ResultTable::get_relation_info(
         // of NN.
         if (lines[index] != "$") {
           relation_info.not_nulls =
-              convertArrayNotationToStringVector(lines[index]);
+              convertArrayNotationToStringVector(std::string(lines[index]));
           index += 2;
         } else  // i.e., it points to the bottom delimiter of NN = upper
                 // delimiter of PK
@@ -2801,7 +3294,7 @@ DBSchemaRelationInfo ResultTable::get_relation_info(
         // of PK.
         if (lines[index] != "$") {
           relation_info.primary_keys =
-              convertArrayNotationToStringVector(lines[index]);
+              convertArrayNotationToStringVector(std::string(lines[index]));
           index += 2;
         } else {
           index += 1;
@@ -2864,13 +3357,13 @@ DBSchemaRelationInfo ResultTable::get_relation_info(
 
       index++;  // we ignore relation_kind
 
-      std::string relation_name = lines[index];
+      std::string relation_name(lines[index]);
       relation_info.name = relation_name;
 
       index++;
       int col_index = 1;
       while (index < lines.size() && lines[index] != "$") {
-        std::string column_name = lines[index];
+        std::string column_name(lines[index]);
         TypeAndLength type = get_Type_from_str(lines[index + 1]);
 
         relation_info.columns_index_map.insert({column_name, col_index});
@@ -2920,7 +3413,7 @@ std::unordered_map<std::string, DBSchemaRelationInfo> ResultTable::get_all_relat
   // Table name -> DBSchemaRelationInfo structure
   std::unordered_map<std::string, DBSchemaRelationInfo> main_map;
 
-  std::vector<std::string> lines = getLines(str);
+  std::vector<std::string_view> lines = getLines(str);
   // Table name -> its TAPI output
   std::unordered_map<std::string, std::string> table_str_map;
 
@@ -3012,6 +3505,16 @@ ResultTable::ResultTable(COMMAND_TYPE type, const std::string& output) {
     Original author: DESODBC Developer
 */
 ResultTable::ResultTable(STMT *stmt) {
+  this->set_params(stmt);
+  this->str = stmt->last_output;
+
+  this->build_table();
+}
+
+/* DESODBC:
+    Original author: DESODBC Developer
+*/
+void ResultTable::set_params(STMT *stmt) {
   this->dbc = stmt->dbc;
   this->params.column_name = stmt->params_for_table.column_name;
   this->params.table_name = stmt->params_for_table.table_name;
@@ -3025,9 +3528,6 @@ ResultTable::ResultTable(STMT *stmt) {
       this->params.metadata_id = true;
   else
     this->params.metadata_id = stmt->stmt_options.metadata_id;
-  this->str = stmt->last_output;
-
-  this->build_table();
 }
 
 /* DESODBC:
@@ -3204,23 +3704,24 @@ void ResultTable::build_table_SQLColumns() {
     return;
   }
 
-  std::vector<std::string> candidate_dbs = getLines(dbs_str);
-  candidate_dbs.erase(
-      std::remove(candidate_dbs.begin(), candidate_dbs.end(), "$eot"),
-      candidate_dbs.end());
+  std::vector<std::string> candidate_dbs;
+  for (std::string_view line : getLines(dbs_str))
+    if (line != "$eot") candidate_dbs.emplace_back(line);
 
   dbs = filter_candidates(candidate_dbs, catalog_name_param,
                           this->params.metadata_id);
 
+  // The current database and the schemas of all the candidate ones are
+  // asked for in a single batch
+  std::vector<std::string> info_queries = {"/current_db"};
+  for (const std::string &db : dbs) info_queries.push_back("/dbschema " + db);
+  auto infos = this->dbc->send_queries_and_read(info_queries);
+  if (!SQL_SUCCEEDED(infos.first)) return;
+
+  std::string previous_db(getLines(infos.second[0])[0]);
+
   for (int i = 0; i < dbs.size(); ++i) {
-    std::string query_dbschema = "/dbschema ";
-    query_dbschema += dbs[i];
-    auto pair = this->dbc->send_query_and_read(query_dbschema);
-    SQLRETURN rc = pair.first;
-    std::string dbschema_str = pair.second;
-    if (rc != SQL_SUCCESS && rc != SQL_SUCCESS_WITH_INFO) {
-      return;
-    }
+    const std::string &dbschema_str = infos.second[i + 1];
 
     std::unordered_map<std::string, DBSchemaRelationInfo> map =
         get_all_relations_info(dbschema_str);
@@ -3234,45 +3735,30 @@ void ResultTable::build_table_SQLColumns() {
     std::vector<std::string> dbschema_table_names = filter_candidates(
         dbschema_tables, table_name_search, this->params.metadata_id);
 
-    for (auto dbschema_table_name : dbschema_table_names) {
-
-      pair = this->dbc->send_query_and_read("/current_db");
-      rc = pair.first;
-      if (!SQL_SUCCEEDED(rc)) return;
-
-      std::string current_db_output = pair.second;
-      std::string previous_db = getLines(current_db_output)[0];
-
-      std::string query_usedb = "/use_db ";
-      query_usedb += dbs[i];
-
-      pair = this->dbc->send_query_and_read(query_usedb);
-      rc = pair.first;
-      if (!SQL_SUCCEEDED(rc)) return;
-
-      std::string select_query = "select * from " + dbschema_table_name;
-      pair = dbc->send_query_and_read(select_query);
-      rc = pair.first;
-      std::string select_query_output = pair.second;
-      if (rc != SQL_SUCCESS && rc != SQL_SUCCESS_WITH_INFO) {
-        return;
-      }
+    if (dbschema_table_names.empty()) continue;
 
-      std::string query_usepreviousdb = "/use_db ";
-      query_usepreviousdb += previous_db;
+    /*
+      The tables of the database are selected in a single batch, after
+      switching to it, and then we switch back to the previous database.
+    */
+    std::vector<std::string> batch = {"/use_db " + dbs[i]};
+    for (const std::string &dbschema_table_name : dbschema_table_names)
+      batch.push_back("select * from " + dbschema_table_name);
+    batch.push_back("/use_db " + previous_db);
 
-      pair = this->dbc->send_query_and_read(query_usepreviousdb);
-      rc = pair.first;
-      if (!SQL_SUCCEEDED(rc)) return;
+    auto outputs = this->dbc->send_queries_and_read(batch);
+    if (!SQL_SUCCEEDED(outputs.first)) return;
 
-      ResultTable table(SELECT, select_query_output);
+    for (size_t t = 0; t < dbschema_table_names.size(); ++t) {
+      const std::string &dbschema_table_name = dbschema_table_names[t];
+      ResultTable table(SELECT, outputs.second[t + 1]);
 
       std::vector<std::string> col_names = table.names_ordered;
       col_names = filter_candidates(col_names, column_name_search,
                                     this->params.metadata_id);
 
       for (int j = 0; j < col_names.size(); ++j) {
-        Column col = table.columns[col_names[j]];
+        Column &col = table.column(col_names[j]);
         DES_FIELD *field = col.get_DES_FIELD();
         insert_value("TABLE_CAT", dbs[i]);
         insert_value("TABLE_SCHEM", NULL_STR);
@@ -3339,7 +3825,7 @@ void ResultTable::build_table_SQLPrimaryKeys() {
   insert_SQLPrimaryKeys_cols();
 
   // First, we separate the TAPI str into lines.
-  std::vector<std::string> lines = getLines(str);
+  std::vector<std::string_view> lines = getLines(str);
 
   int i = 0;
   DBSchemaRelationInfo table_info = get_relation_info(lines, i);
@@ -3400,10 +3886,9 @@ void ResultTable::build_table_SQLTables() {
     return;
   }
 
-  std::vector<std::string> candidate_dbs = getLines(dbs_str);
-  candidate_dbs.erase(
-      std::remove(candidate_dbs.begin(), candidate_dbs.end(), "$eot"),
-      candidate_dbs.end());
+  std::vector<std::string> candidate_dbs;
+  for (std::string_view line : getLines(dbs_str))
+    if (line != "$eot") candidate_dbs.emplace_back(line);
 
   dbs = filter_candidates(candidate_dbs, catalog_name_param,
                           this->params.metadata_id);
@@ -3429,15 +3914,16 @@ void ResultTable::build_table_SQLTables() {
     }
 
   } else { //standard case
+    // The schemas of all the candidate databases are asked for in a
+    // single batch
+    std::vector<std::string> dbschema_queries;
+    for (const std::string &db : dbs)
+      dbschema_queries.push_back("/dbschema " + db);
+    auto dbschemas = dbc->send_queries_and_read(dbschema_queries);
+    if (!SQL_SUCCEEDED(dbschemas.first)) return;
+
     for (int i = 0; i < dbs.size(); ++i) {
-      std::string dbschema_query = "/dbschema ";
-      dbschema_query += dbs[i];
-      auto pair = dbc->send_query_and_read(dbschema_query);
-      SQLRETURN rc = pair.first;
-      std::string dbschema_query_output = pair.second;
-      if (rc != SQL_SUCCESS && rc != SQL_SUCCESS_WITH_INFO) {
-        return;
-      }
+      const std::string &dbschema_query_output = dbschemas.second[i];
 
       std::unordered_map<std::string, DBSchemaRelationInfo> map =
           get_all_relations_info(dbschema_query_output);
@@ -3450,7 +3936,7 @@ void ResultTable::build_table_SQLTables() {
       std::vector<std::string> dbschema_table_names = filter_candidates(
           dbschema_tables, table_name_param, this->params.metadata_id);
 
-      std::vector<std::string> lines = getLines(dbschema_query_output);
+      std::vector<std::string_view> lines = getLines(dbschema_query_output);
 
       int j = 0;
 
@@ -3514,77 +4000,154 @@ void ResultTable::build_table_SQLTables() {
 }
 
 /* DESODBC:
+    This function processes the next line of a TAPI output. The first one
+    tells whether it is the answer to a SELECT; if not, the output is kept
+    as is.
+
     Original author: DESODBC Developer
 */
-void ResultTable::build_table_select() {
-
-  // First, we separate the TAPI str into lines.
-  std::vector<std::string> lines = getLines(str);
-
-  std::vector<std::string> column_names;
+void TapiSelectParser::on_line(std::string_view line, bool newline) {
+  std::string_view original = line;
+  line = trim_line_end(line);
+  if (n_lines == 0) {
+    size_t first_pos = line.find_first_not_of(" \t");
+    line.remove_prefix(first_pos == std::string_view::npos ? line.size()
+                                                           : first_pos);
+  }
+  n_lines++;
 
-  // We ignore the first line, that contains the keywords success/answer.
-  int i = 1;
+  switch (state) {
+    case EXPECT_ANSWER:
+      if (line == "answer") {
+        state = EXPECT_FIRST_COLUMN;
+        return;
+      }
+      state = NOT_SELECT;
+      break;
 
-  //No columns: we are dealing with an empty table.
-  if (lines[i] == "$")
+    case EXPECT_FIRST_COLUMN:
+      // No columns: we are dealing with an empty table.
+      if (line == "$" || line == "$eot") {
+        state = FINISHED;
+        return;
+      }
+      pending_column.assign(line.data(), line.size());
+      state = EXPECT_COLUMN_TYPE;
       return;
 
-  // If the first message is not answer, we can be sure that the output
-  // originates from a non-select query. We then create the default
-  // metadata table on the else clause.
-  if (lines.size() >= 1 && lines[0] == "answer") {
-    bool checked_cols = false;
-
-    while (!checked_cols && lines[i] != "$eot") {
+    case EXPECT_COLUMN_TYPE: {
       // For each column, TAPI gives in a line its name and then its type.
-      size_t pos_dot = lines[i].find('.', 0);
-      std::string table = lines[i].substr(0, pos_dot);
-      this->table_name = table;
-      std::string name = lines[i].substr(pos_dot + 1, lines[i].size() - (pos_dot+1));
-      TypeAndLength type = get_Type_from_str(lines[i + 1]);
+      size_t pos_dot = pending_column.find('.', 0);
+      std::string table_name = pending_column.substr(0, pos_dot);
+      table->table_name = table_name;
+      std::string name = pending_column.substr(pos_dot + 1);
+      TypeAndLength type = get_Type_from_str(line);
 
       // I have put SQL_NULLABLE_UNKNOWN because I do not know
       // if a result table from select may have an attribute "nullable"
-      insert_col(table, name, type, SQL_NULLABLE_UNKNOWN);
+      table->insert_col(table_name, name, type, SQL_NULLABLE_UNKNOWN);
+      n_columns++;
+      state = EXPECT_COLUMN;
+      return;
+    }
 
-      column_names.push_back(name);
+    case EXPECT_COLUMN:
+      if (line == "$")
+        state = EXPECT_ROW;
+      else if (line == "$eot")
+        state = FINISHED;
+      else {
+        pending_column.assign(line.data(), line.size());
+        state = EXPECT_COLUMN_TYPE;
+      }
+      return;
 
-      i += 2;
+    case EXPECT_ROW:
+      if (line == "$eot") {
+        state = FINISHED;
+        return;
+      }
+      current_col = 0;
+      state = EXPECT_VALUE;
+      // The line is the first value of the row
+      // fall through
+    case EXPECT_VALUE:
+      if (line == "null")
+        table->insert_value(current_col, nullptr, 0);
+      else {
+        // When we reach a varchar value, we remove the " ' " characters
+        // provided by the TAPI.
+        line = unquote_tapi_value(line);
+        table->insert_value(current_col, line.data(), line.size());
+      }
+      if (++current_col == n_columns) state = EXPECT_ROW_END;
+      return;
 
-      if (lines[i] == "$") checked_cols = true;
-    }
+    case EXPECT_ROW_END:
+      // $ separates rows, $eot closes the table.
+      state = line == "$eot" ? FINISHED : EXPECT_ROW;
+      return;
 
-    i++;  // We skip the final $
-    if (i == lines.size()) return;
-    std::string aux = lines[i];
-    while (aux != "$eot") {
-      for (int j = 0; j < column_names.size(); ++j) {
-        std::string name_col = column_names[j];
-        std::string value = lines[i];
+    case FINISHED:
+      trailing.append(line.data(), line.size());
+      if (newline) trailing += '\n';
+      return;
 
-        if (value == "null")
-          insert_value(name_col, nullptr);
-        else {
-          // When we reach a varchar value, we remove the " ' " characters
-          // provided by the TAPI.
-          if (value.size() > 0 && value[0] == '\'') {
-            value = value.substr(1, value.size() - 2);
-          }
+    case NOT_SELECT:
+      break;
+  }
 
-          insert_value(name_col, value);
-        }
+  // NOT_SELECT: we keep the output so that it can be checked later.
+  if (n_lines == 2 && line == "$") second_line_is_dollar = true;
+  raw.append(original.data(), original.size());
+  if (newline) raw += '\n';
+}
 
-        i++;
-      }
-      aux = lines[i];
-      i++;  // to skip $ or $eot
+/* DESODBC:
+    Feeds the parser with a TAPI output that has already been read.
+    Original author: DESODBC Developer
+*/
+void TapiSelectParser::feed(const std::string &output) {
+  size_t start = 0;
+  while (start < output.size()) {
+    size_t end = output.find('\n', start);
+    if (end == std::string::npos) {
+      on_line(std::string_view(output).substr(start), false);
+      break;
     }
-  } else {  // if it is not possible, we create the default metadata table.
-    insert_metadata_cols();
+    on_line(std::string_view(output).substr(start, end - start), true);
+    start = end + 1;
   }
 }
 
+/* DESODBC:
+    Reading pauses between rows once the window is full.
+    Original author: DESODBC Developer
+*/
+bool TapiSelectParser::paused() {
+  return window_rows != 0 && state == EXPECT_ROW_END &&
+         table->row_count() >= window_rows;
+}
+
+/* DESODBC:
+    Called once the whole output has been parsed. If it was not the answer
+    to a SELECT, we create the default metadata table.
+    Original author: DESODBC Developer
+*/
+void TapiSelectParser::finish() {
+  if (state == NOT_SELECT && !second_line_is_dollar)
+    table->insert_metadata_cols();
+}
+
+/* DESODBC:
+    Original author: DESODBC Developer
+*/
+void ResultTable::build_table_select() {
+  TapiSelectParser parser(this);
+  parser.feed(str);
+  parser.finish();
+}
+
 /* DESODBC:
     Original author: DESODBC Developer
 */
@@ -3629,26 +4192,23 @@ void ResultTable::build_table_SQLSpecialColumns() {
 
   std::string main_query = "/dbschema ";
   main_query += table_name;
-  auto pair = dbc->send_query_and_read(main_query);
-  SQLRETURN rc = pair.first;
-  std::string main_output = pair.second;
-  if (rc != SQL_SUCCESS && rc != SQL_SUCCESS_WITH_INFO) {
-    return;
-  }
-
-  std::vector<std::string> lines = getLines(main_output);
-  int index = 0;
-  DBSchemaRelationInfo table_info = get_relation_info(lines, index);
 
   //We need the table so as to know the buffer length for character data types.
   std::string select_query = "select * from ";
   select_query += table_name;
-  pair = dbc->send_query_and_read(select_query);
-  rc = pair.first;
-  std::string select_query_output = pair.second;
+
+  // Both are independent, so they are sent as a single batch
+  auto outputs = dbc->send_queries_and_read({main_query, select_query});
+  SQLRETURN rc = outputs.first;
   if (rc != SQL_SUCCESS && rc != SQL_SUCCESS_WITH_INFO) {
     return;
   }
+  const std::string &main_output = outputs.second[0];
+  const std::string &select_query_output = outputs.second[1];
+
+  std::vector<std::string_view> lines = getLines(main_output);
+  int index = 0;
+  DBSchemaRelationInfo table_info = get_relation_info(lines, index);
 
   ResultTable table(SELECT, select_query_output);
 
@@ -3663,7 +4223,7 @@ void ResultTable::build_table_SQLSpecialColumns() {
 
     if (is_character_des_data_type(type.simple_type) && type.len == UINT64_MAX) {
       insert_value("BUFFER_LENGTH",
-                   std::to_string(table.columns[primary_key].getMaxLength()));
+                   std::to_string(table.column(primary_key).getMaxLength()));
     } else
       insert_value("BUFFER_LENGTH",
                    std::to_string(get_transfer_octet_length(type)));
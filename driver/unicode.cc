@@ -78,6 +78,7 @@ SQLColAttributeW(SQLHSTMT hstmt, SQLUSMALLINT column,
 #endif
                )
 {
+  CHECK_STMT_IDLE(hstmt);
   LOCK_STMT(hstmt);
 
   return SQLColAttributeWImpl(hstmt, column, field, char_attr, char_attr_max,
@@ -145,6 +146,7 @@ SQLColumnPrivilegesW(SQLHSTMT hstmt,
                      SQLWCHAR *table, SQLSMALLINT table_len,
                      SQLWCHAR *column, SQLSMALLINT column_len)
 {
+  CHECK_STMT_IDLE(hstmt);
   return ((STMT *)hstmt)->set_error("IM001", "DESODBC does not support this function");
 }
 
@@ -159,6 +161,7 @@ SQLColumnsW(SQLHSTMT hstmt,
             SQLWCHAR *table, SQLSMALLINT table_len,
             SQLWCHAR *column, SQLSMALLINT column_len)
 {
+  CHECK_STMT_IDLE(hstmt);
   SQLRETURN rc;
   SQLCHAR *catalog8, *schema8, *table8, *column8;
   SQLINTEGER len;
@@ -243,6 +246,7 @@ SQLDescribeColW(SQLHSTMT hstmt, SQLUSMALLINT column,
                 SQLWCHAR *name, SQLSMALLINT name_max, SQLSMALLINT *name_len,
                 SQLSMALLINT *type, SQLULEN *size, SQLSMALLINT *scale, //TODO: scale has been renamed to decimal_digits in a newer ODBC version. Change headers.
                 SQLSMALLINT *nullable) {
+  CHECK_STMT_IDLE(hstmt);
   STMT *stmt = (STMT *)hstmt;
   SQLCHAR *value = NULL;
   SQLWCHAR *wvalue = NULL;
@@ -293,10 +297,24 @@ SQLExecDirectW(SQLHSTMT hstmt, SQLWCHAR *str, SQLINTEGER str_len)
 {
   int error;
 
+  CHECK_HANDLE(hstmt);
+  STMT *stmt = (STMT *)hstmt;
+
+  /* DESODBC: the statement is locked by the worker while it is executed */
+  if (stmt->async_result.valid())
+    return stmt->poll_async(SQL_API_SQLEXECDIRECT);
+
   LOCK_STMT(hstmt);
 
   if ((error= SQLPrepareWImpl(hstmt, str, str_len, false)))
     return error;
+
+  if (stmt->stmt_options.async_enable == SQL_ASYNC_ENABLE_ON)
+    return stmt->start_async(SQL_API_SQLEXECDIRECT, [stmt]() -> SQLRETURN {
+      LOCK_STMT(stmt);
+      return DES_SQLExecute(stmt);
+    });
+
   error= DES_SQLExecute((STMT *)hstmt);
 
   return error;
@@ -315,6 +333,7 @@ SQLForeignKeysW(SQLHSTMT hstmt,
                 SQLWCHAR *fk_schema, SQLSMALLINT fk_schema_len,
                 SQLWCHAR *fk_table, SQLSMALLINT fk_table_len)
 {
+  CHECK_STMT_IDLE(hstmt);
   SQLRETURN rc;
   SQLCHAR *pk_catalog8, *pk_schema8, *pk_table8, *fk_catalog8, *fk_schema8,
       *fk_table8;
@@ -468,6 +487,7 @@ SQLRETURN SQL_API
 SQLGetCursorNameW(SQLHSTMT hstmt, SQLWCHAR *cursor, SQLSMALLINT cursor_max,
                   SQLSMALLINT *cursor_len)
 {
+  CHECK_STMT_IDLE(hstmt);
   SQLRETURN rc= SQL_SUCCESS;
   STMT *stmt= (STMT *)hstmt;
   SQLWCHAR *name;
@@ -748,6 +768,7 @@ SQLRETURN SQL_API
 SQLGetStmtAttrW(SQLHSTMT hstmt, SQLINTEGER attribute, SQLPOINTER value,
                 SQLINTEGER value_max, SQLINTEGER *value_len)
 {
+  CHECK_STMT_IDLE(hstmt);
   LOCK_STMT(hstmt);
 
   return DESGetStmtAttr(hstmt, attribute, value, value_max, value_len);
@@ -761,6 +782,7 @@ SQLGetStmtAttrW(SQLHSTMT hstmt, SQLINTEGER attribute, SQLPOINTER value,
 SQLRETURN SQL_API
 SQLGetTypeInfoW(SQLHSTMT hstmt, SQLSMALLINT type)
 {
+  CHECK_STMT_IDLE(hstmt);
   LOCK_STMT(hstmt);
 
   SQLRETURN rc;
@@ -807,6 +829,7 @@ SQLNativeSqlW(SQLHDBC hdbc, SQLWCHAR *in, SQLINTEGER in_len,
 SQLRETURN SQL_API
 SQLPrepareW(SQLHSTMT hstmt, SQLWCHAR *str, SQLINTEGER str_len)
 {
+  CHECK_STMT_IDLE(hstmt);
   LOCK_STMT(hstmt);
 
   return SQLPrepareWImpl(hstmt, str, str_len, true);
@@ -842,6 +865,7 @@ SQLPrimaryKeysW(SQLHSTMT hstmt,
                 SQLWCHAR *catalog, SQLSMALLINT catalog_len,
                 SQLWCHAR *schema, SQLSMALLINT schema_len,
                 SQLWCHAR *table, SQLSMALLINT table_len) {
+  CHECK_STMT_IDLE(hstmt);
   SQLRETURN rc;
   SQLCHAR *catalog8, *schema8, *table8;
   SQLINTEGER len;
@@ -891,6 +915,7 @@ SQLProcedureColumnsW(SQLHSTMT hstmt,
                      SQLWCHAR *proc, SQLSMALLINT proc_len,
                      SQLWCHAR *column, SQLSMALLINT column_len)
 {
+  CHECK_STMT_IDLE(hstmt);
   return ((STMT *)hstmt)
       ->set_error("IM001", "DESODBC does not support this function");
 }
@@ -905,6 +930,7 @@ SQLProceduresW(SQLHSTMT hstmt,
                SQLWCHAR *schema, SQLSMALLINT schema_len,
                SQLWCHAR *proc, SQLSMALLINT proc_len)
 {
+  CHECK_STMT_IDLE(hstmt);
   return ((STMT *)hstmt)
       ->set_error("IM001", "DESODBC does not support this function");
 }
@@ -934,7 +960,8 @@ SQLSetConnectAttrWImpl(SQLHDBC hdbc, SQLINTEGER attribute,
   SQLINTEGER len= value_len == SQL_NTS ? SQL_NTS : value_len;
 #endif
 
-  if (attribute == SQL_ATTR_CURRENT_CATALOG)
+  if (attribute == SQL_ATTR_CURRENT_CATALOG ||
+      (attribute == DES_ATTR_SAVE_SNAPSHOT && value))
   {
     uint errors= 0;
 
@@ -967,6 +994,7 @@ SQLSetConnectAttrWImpl(SQLHDBC hdbc, SQLINTEGER attribute,
 SQLRETURN SQL_API
 SQLSetCursorNameW(SQLHSTMT hstmt, SQLWCHAR *name, SQLSMALLINT name_len)
 {
+  CHECK_STMT_IDLE(hstmt);
   SQLRETURN rc;
   SQLINTEGER len= name_len;
   uint errors= 0;
@@ -999,6 +1027,7 @@ SQLRETURN SQL_API
 SQLSetStmtAttrW(SQLHSTMT hstmt, SQLINTEGER attribute,
                 SQLPOINTER value, SQLINTEGER value_len)
 {
+  CHECK_STMT_IDLE(hstmt);
   LOCK_STMT(hstmt);
 
   /* Nothing special to do, since we don't have any string stmt attribs */
@@ -1016,6 +1045,7 @@ SQLSpecialColumnsW(SQLHSTMT hstmt, SQLUSMALLINT type,
                    SQLWCHAR *table, SQLSMALLINT table_len,
                    SQLUSMALLINT scope, SQLUSMALLINT nullable)
 {
+  CHECK_STMT_IDLE(hstmt);
   SQLRETURN rc;
   SQLCHAR *catalog8, *schema8, *table8;
   SQLINTEGER len;
@@ -1066,6 +1096,7 @@ SQLStatisticsW(SQLHSTMT hstmt,
                SQLWCHAR *table, SQLSMALLINT table_len,
                SQLUSMALLINT unique, SQLUSMALLINT accuracy)
 {
+  CHECK_STMT_IDLE(hstmt);
   SQLRETURN rc;
   SQLCHAR *catalog8, *schema8, *table8;
   SQLINTEGER len;
@@ -1114,6 +1145,7 @@ SQLTablePrivilegesW(SQLHSTMT hstmt,
                     SQLWCHAR *schema, SQLSMALLINT schema_len,
                     SQLWCHAR *table, SQLSMALLINT table_len)
 {
+  CHECK_STMT_IDLE(hstmt);
   return ((STMT *)hstmt)
       ->set_error("IM001", "DESODBC does not support this function");
 }
@@ -1129,6 +1161,7 @@ SQLTablesW(SQLHSTMT hstmt,
            SQLWCHAR *table, SQLSMALLINT table_len,
            SQLWCHAR *type, SQLSMALLINT type_len)
 {
+  CHECK_STMT_IDLE(hstmt);
   SQLRETURN rc;
   SQLCHAR *catalog8, *schema8, *table8, *type8;
   SQLINTEGER len;
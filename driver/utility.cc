@@ -42,10 +42,17 @@
 
 #include "driver.h"
 #include "errmsg.h"
+#include "my_byteorder.h"
 #include <ctype.h>
 #include <iostream>
 #include <map>
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ASCII_SIMD 1
+#include <emmintrin.h>
+#endif
+
 #define DATETIME_DIGITS 14
 
 const SQLULEN sql_select_unlimited= (SQLULEN)-1;
@@ -332,6 +339,74 @@ copy_ansi_result(STMT *stmt,
 }
 
 
+/* DESODBC:
+    Returns how many bytes from src on are 7-bit ASCII, looking at sixteen
+    of them at a time where SSE2 is available and eight otherwise.
+
+    Original author: DESODBC Developer
+*/
+static size_t ascii_prefix(const char *src, const char *src_end)
+{
+  const char *p= src;
+
+#ifdef ASCII_SIMD
+  for (; src_end - p >= 16; p+= 16)
+  {
+    int high= _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)p));
+    if (high)
+    {
+      unsigned long first= 0;
+      while (!(high & (1 << first)))
+        ++first;
+      return (size_t)(p - src) + first;
+    }
+  }
+#endif
+
+  for (; src_end - p >= 8; p+= 8)
+  {
+    if (uint8korr(p) & 0x8080808080808080ULL)
+      break;
+  }
+
+  while (p < src_end && !(*p & 0x80))
+    ++p;
+
+  return (size_t)(p - src);
+}
+
+/* DESODBC:
+    Widens count ASCII bytes from src into UTF-16 code units, which are
+    the same values.
+
+    Original author: DESODBC Developer
+*/
+static void widen_ascii(SQLWCHAR *dst, const char *src, size_t count)
+{
+  size_t i= 0;
+
+#ifdef ASCII_SIMD
+  if (sizeof(SQLWCHAR) == 2)
+  {
+    const __m128i zero= _mm_setzero_si128();
+    for (; i + 16 <= count; i+= 16)
+    {
+      __m128i chunk= _mm_loadu_si128((const __m128i *)(src + i));
+      _mm_storeu_si128((__m128i *)(dst + i), _mm_unpacklo_epi8(chunk, zero));
+      _mm_storeu_si128((__m128i *)(dst + i + 8),
+                       _mm_unpackhi_epi8(chunk, zero));
+    }
+  }
+#endif
+
+  for (; i < count; ++i)
+    dst[i]= (SQLWCHAR)(unsigned char)src[i];
+}
+
+/* DESODBC:
+    Original author: MyODBC
+    Modified by: DESODBC Developer
+*/
 /**
   Copy a result from the server into a buffer as a SQL_C_WCHAR.
 
@@ -405,6 +480,37 @@ copy_wchar_result(STMT *stmt,
 
   while (src < src_end)
   {
+    /*
+      DES output is nearly always ASCII, which is the same in UTF-8 and
+      UTF-16: a run of it is copied at once, the same way as the
+      character by character loop below would do it.
+    */
+    size_t ascii= ascii_prefix(src, src_end);
+    if (ascii)
+    {
+      if (result)
+      {
+        size_t copied= desodbc_min(ascii, (size_t)(result_end - result));
+
+        if (stmt->stmt_options.retrieve_data)
+          widen_ascii(result, src, copied);
+        result+= copied;
+        stmt->getdata.source+= copied;
+
+        if (result == result_end)
+        {
+          if (stmt->stmt_options.retrieve_data)
+            *result= 0;
+          result= NULL;
+        }
+      }
+
+      /* What does not fit is only counted */
+      src+= ascii;
+      used_chars+= (ulong)ascii;
+      continue;
+    }
+
     /* Find the conversion functions. */
     auto mb_wc = from_cs->cset->mb_wc;
     auto wc_mb = utf16_charset_info->cset->wc_mb;
@@ -1378,6 +1484,126 @@ SQLLEN get_bookmark_value(SQLSMALLINT fCType, SQLPOINTER rgbValue)
 }
 
 
+/* DESODBC:
+    DES prints its temporal values with a fixed layout: 'YYYY-MM-DD' for
+    dates, 'HH:MM:SS' for times and 'YYYY-MM-DD HH:MM:SS' for datetimes.
+    The functions below check and decode eight characters of such a layout
+    at once in a 64-bit word (the first character in the lowest byte),
+    so that these values skip the generic parsers.
+
+    Original author: DESODBC Developer
+*/
+static inline unsigned long long load_layout_word(const char *str)
+{
+  return uint8korr(str);
+}
+
+/* DESODBC:
+    Masks of a layout of eight characters, where '9' stands for a digit and
+    any other character must appear as it is.
+
+    Original author: DESODBC Developer
+*/
+struct TemporalLayout
+{
+  unsigned long long digits;     /* 0xFF on the bytes of digits */
+  unsigned long long separators; /* the separators, 0 on the digits */
+
+  constexpr TemporalLayout(const char (&layout)[9])
+    : digits(0), separators(0)
+  {
+    for (int i= 0; i < 8; ++i)
+    {
+      if (layout[i] == '9')
+        digits|= 0xFFULL << (8 * i);
+      else
+        separators|= (unsigned long long)(unsigned char)layout[i] << (8 * i);
+    }
+  }
+};
+
+constexpr TemporalLayout LAYOUT_DATE_HEAD("9999-99-");  /* YYYY-MM- */
+constexpr TemporalLayout LAYOUT_DATE_TAIL("99-99-99");  /* YY-MM-DD */
+constexpr TemporalLayout LAYOUT_TIME("99:99:99");       /* HH:MM:SS */
+
+/* DESODBC:
+    If word follows layout, this function returns true and leaves in pairs
+    the value of every two digits starting at byte i in byte i, that is,
+    (pairs >> 8 * i) & 0xFF. Digits are checked by their high nibble being
+    3 and stay so after adding 6, and the pairs are formed with a single
+    multiply-add since no byte can exceed 99.
+
+    Original author: DESODBC Developer
+*/
+static inline bool decode_layout_word(unsigned long long word,
+                                      const TemporalLayout &layout,
+                                      unsigned long long &pairs)
+{
+  const unsigned long long high_nibbles= 0xF0F0F0F0F0F0F0F0ULL;
+  const unsigned long long threes= 0x3030303030303030ULL;
+  const unsigned long long sixes= 0x0606060606060606ULL;
+
+  unsigned long long digits= word & layout.digits;
+  bool ok= (word & ~layout.digits) == layout.separators &&
+           (digits & high_nibbles) == (threes & layout.digits) &&
+           ((digits + (sixes & layout.digits)) & high_nibbles) ==
+             (threes & layout.digits);
+
+  unsigned long long values= (digits - (threes & layout.digits));
+  pairs= values * 10 + (values >> 8);
+  return ok;
+}
+
+static inline unsigned pair_at(unsigned long long pairs, int i)
+{
+  return (unsigned)(pairs >> (8 * i)) & 0xFF;
+}
+
+/* DESODBC:
+    Fast path for a 'YYYY-MM-DD' date at the start of str, which must have
+    at least 10 characters. Dates whose month or day is zero are left to
+    the generic parsers, which know what to do with them.
+
+    Original author: DESODBC Developer
+*/
+static bool fixed_layout_date(const char *str, unsigned *year,
+                              unsigned *month, unsigned *day)
+{
+  unsigned long long head, tail;
+  bool ok= decode_layout_word(load_layout_word(str), LAYOUT_DATE_HEAD, head);
+  ok&= decode_layout_word(load_layout_word(str + 2), LAYOUT_DATE_TAIL, tail);
+  if (!ok)
+    return false;
+
+  *year= pair_at(head, 0) * 100 + pair_at(head, 2);
+  *month= pair_at(head, 5);
+  *day= pair_at(tail, 6);
+  return *month != 0 && *day != 0;
+}
+
+/* DESODBC:
+    Fast path for a 'HH:MM:SS' time at the start of str, which must have
+    at least 8 characters.
+
+    Original author: DESODBC Developer
+*/
+static bool fixed_layout_time(const char *str, unsigned *hour,
+                              unsigned *minute, unsigned *second)
+{
+  unsigned long long pairs;
+  if (!decode_layout_word(load_layout_word(str), LAYOUT_TIME, pairs))
+    return false;
+
+  *hour= pair_at(pairs, 0);
+  *minute= pair_at(pairs, 3);
+  *second= pair_at(pairs, 6);
+  return true;
+}
+
+/* DESODBC:
+    Original author: MyODBC
+    Modified by: DESODBC Developer
+*/
 /*
   @type    : myodbc internal
   @purpose : convert a possible string to a timestamp value
@@ -1403,6 +1629,25 @@ int str_to_ts(SQL_TIMESTAMP_STRUCT *ts, const char *str, int len, int zeroToMin,
       len = (int)strlen(str);
     }
 
+    /* DES dates and datetimes */
+    if (len == 10 || (len == 19 && str[10] == ' '))
+    {
+      unsigned month, day, hour= 0, minute= 0, second= 0;
+
+      if (fixed_layout_date(str, &year, &month, &day) &&
+          (len == 10 || fixed_layout_time(str + 11, &hour, &minute, &second)))
+      {
+        ts->year=     year;
+        ts->month=    month;
+        ts->day=      day;
+        ts->hour=     hour;
+        ts->minute=   minute;
+        ts->second=   second;
+        ts->fraction= 0;
+        return 0;
+      }
+    }
+
     /* We don't wan to change value in the out parameter directly
        before we know that string is a good datetime */
     end= get_fractional_part(str, len, dont_use_set_locale, &fraction);
@@ -1483,6 +1728,10 @@ int str_to_ts(SQL_TIMESTAMP_STRUCT *ts, const char *str, int len, int zeroToMin,
     return 0;
 }
 
+/* DESODBC:
+    Original author: MyODBC
+    Modified by: DESODBC Developer
+*/
 /*
   @type    : myodbc internal
   @purpose : convert a possible string to a time value
@@ -1493,10 +1742,21 @@ my_bool str_to_time_st(SQL_TIME_STRUCT *ts, const char *str)
     char buff[24],*to, *tokens[3] = {0, 0, 0};
     int num= 0, int_hour=0, int_min= 0, int_sec= 0;
     SQL_TIME_STRUCT tmp_time;
+    unsigned hour, minute, second;
 
     if ( !ts )
         ts= (SQL_TIME_STRUCT *) &tmp_time;
 
+    /* DES times */
+    if (strnlen(str, 9) == 8 && fixed_layout_time(str, &hour, &minute, &second)
+        && minute < 60 && second < 60)
+    {
+      ts->hour   = (SQLUSMALLINT)hour;
+      ts->minute = (SQLUSMALLINT)minute;
+      ts->second = (SQLUSMALLINT)second;
+      return 0;
+    }
+
     /* remember the position of the first numeric string */
     tokens[0]= buff;
 
@@ -1546,6 +1806,10 @@ my_bool str_to_time_st(SQL_TIME_STRUCT *ts, const char *str)
     return 0;
 }
 
+/* DESODBC:
+    Original author: MyODBC
+    Modified by: DESODBC Developer
+*/
 /*
   @type    : myodbc internal
   @purpose : convert a possible string to a data value. if
@@ -1559,6 +1823,20 @@ my_bool str_to_date(SQL_DATE_STRUCT *rgbValue, const char *str,
     uint field_length,year_length,digits,i,date[3];
     const char *pos;
     const char *end= str+length;
+
+    /* DES dates, and the date of DES datetimes */
+    if (length == 10 || (length > 10 && !isdigit(str[10])))
+    {
+      unsigned year, month, day;
+      if (fixed_layout_date(str, &year, &month, &day))
+      {
+        rgbValue->year=  year;
+        rgbValue->month= month;
+        rgbValue->day=   day;
+        return 0;
+      }
+    }
+
     for ( ; !isdigit(*str) && str != end ; ++str ) ;
     /*
       Calculate first number of digits.
@@ -2469,25 +2747,50 @@ BOOL myodbc_isnum(desodbc::CHARSET_INFO* cs, const char * begin, const char *end
 }
 
 /* DESODBC:
-* This function fetch the output of the TAPI and transforms it
-* into the list of lines. We also filter non-printing spaces and
-* carriage returns.
+* This function splits the output of the TAPI into its lines. They are
+* views into str, so it must outlive them. We also filter the leading
+* non-printing spaces of the output and the carriage returns.
     Original author: DESODBC Developer
 */
-std::vector<std::string> getLines(const std::string &str) {
-  std::vector<std::string> lines;
+std::vector<std::string_view> getLines(std::string_view str) {
+  std::vector<std::string_view> lines;
   size_t first_pos = str.find_first_not_of(" \t\r");
-  std::string new_str = str.substr(first_pos, str.size() - first_pos);
+  if (first_pos == std::string_view::npos) return lines;
+  str.remove_prefix(first_pos);
+
+  const char *pos = str.data();
+  const char *end = pos + str.size();
+  while (pos < end) {
+    // memchr is the vectorized scan of the C library
+    const char *nl = (const char *)memchr(pos, '\n', end - pos);
+    const char *line_end = nl ? nl : end;
+    lines.push_back(trim_line_end(std::string_view(pos, line_end - pos)));
+    if (!nl) break;
+    pos = nl + 1;
+  }
+  return lines;
+}
 
-  std::stringstream ss(new_str);
-  std::string line;
+/* DESODBC:
+    Removes the carriage returns that end a line ("\r\n" endings).
+    Original author: DESODBC Developer
+*/
+std::string_view trim_line_end(std::string_view line) {
+  while (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+  return line;
+}
 
-  while (std::getline(ss, line, '\n')) {
-    //Removing CR
-    line.erase(std::remove(line.begin(), line.end(), 13), line.end());
-    lines.push_back(line);
+/* DESODBC:
+    TAPI encloses string values between " ' " characters: this function
+    returns the value without them.
+    Original author: DESODBC Developer
+*/
+std::string_view unquote_tapi_value(std::string_view value) {
+  if (value.size() > 0 && value[0] == '\'') {
+    value.remove_prefix(1);
+    if (value.size() > 0) value.remove_suffix(1);
   }
-  return lines;
+  return value;
 }
 
 /* DESODBC:
@@ -2536,8 +2839,8 @@ wchar_t *string_to_wchar_pointer(const std::wstring &w_str) {
 /* DESODBC:
     Original author: DESODBC Developer
 */
-TypeAndLength get_Type_from_str(const std::string &str) {
-  std::string type_str = str;
+TypeAndLength get_Type_from_str(std::string_view str) {
+  std::string type_str(str);
   SQLULEN size = -1;
 
   std::transform(type_str.begin(), type_str.end(), type_str.begin(),
@@ -2972,7 +3275,7 @@ SQLRETURN set_error_from_tapi_output(SQLSMALLINT HandleType, SQLHANDLE Handle,
   advantage.
   */
 
-  std::vector<std::string> lines = getLines(tapi_output);
+  std::vector<std::string_view> lines = getLines(tapi_output);
 
   /*
     We already know there is a $error. But only when we find
@@ -121,6 +121,8 @@ const char usage[] =
 "|     -l list                                                          \n"
 "|     -a add (add/update for data source)                              \n"
 "|     -r remove                                                        \n"
+"|     -w warm up (data source only): connect and disconnect, so that a  \n"
+"|        data source with DES_LINGER has its DES process ready         \n"
 "|     -h display this help page and exit                               \n"
 "|                                                                      \n"
 "| Options                                                              \n"
@@ -193,6 +195,7 @@ const char usage[] =
 #define ACTION_LIST 'l'
 #define ACTION_ADD 'a'
 #define ACTION_REMOVE 'r'
+#define ACTION_WARM 'w'
 #define ACTION_HELP 'h'
 
 #define OPT_DSN 'n'
@@ -726,6 +729,59 @@ int remove_datasource(DataSource *ds)
 }
 
 
+/* DESODBC:
+    Original author: DESODBC Developer
+*/
+/*
+ * Handler for "warm up data source" command (-s -w -n dsn [-t attrs])
+ *
+ * The connection launches the DES process of the data source if it is not
+ * running, and with DES_LINGER it is kept running after we disconnect.
+ */
+int warm_datasource()
+{
+  SQLHANDLE env, dbc;
+  std::string conn_str= std::string("DSN=") + name;
+  int rc= 0;
+
+  if (attrstr)
+    conn_str+= std::string(";") + attrstr;
+
+  if (SQLAllocHandle(SQL_HANDLE_ENV, SQL_NULL_HANDLE, &env) != SQL_SUCCESS)
+  {
+    fprintf(stderr, "[ERROR] Failed to allocate env handle\n");
+    return 1;
+  }
+
+  if (SQLSetEnvAttr(env, SQL_ATTR_ODBC_VERSION, (SQLPOINTER)SQL_OV_ODBC3,
+                    SQL_IS_INTEGER) != SQL_SUCCESS ||
+      SQLAllocHandle(SQL_HANDLE_DBC, env, &dbc) != SQL_SUCCESS)
+  {
+    print_odbc_error(env, SQL_HANDLE_ENV);
+    SQLFreeHandle(SQL_HANDLE_ENV, env);
+    return 1;
+  }
+
+  if (SQL_SUCCEEDED(SQLDriverConnect(dbc, NULL, (SQLCHAR *)conn_str.c_str(),
+                                     SQL_NTS, NULL, 0, NULL,
+                                     SQL_DRIVER_NOPROMPT)))
+  {
+    SQLDisconnect(dbc);
+    printf("Success\n");
+  }
+  else
+  {
+    print_odbc_error(dbc, SQL_HANDLE_DBC);
+    rc= 1;
+  }
+
+  SQLFreeHandle(SQL_HANDLE_DBC, dbc);
+  SQLFreeHandle(SQL_HANDLE_ENV, env);
+
+  return rc;
+}
+
+
 /*
  * Handle driver actions. We setup a data source object to be used
  * for all actions. Config/scope set+restore is wrapped around the
@@ -742,9 +798,10 @@ int handle_datasource_action()
   {
   case ACTION_ADD:
   case ACTION_REMOVE:
+  case ACTION_WARM:
     if (!name)
     {
-      fprintf(stderr, "[ERROR] Name missing to add/remove data source\n");
+      fprintf(stderr, "[ERROR] Name missing to add/remove/warm up data source\n");
       rc= 1;
       goto end;
     }
@@ -783,6 +840,9 @@ int handle_datasource_action()
   case ACTION_REMOVE:
     rc= remove_datasource(&ds);
     break;
+  case ACTION_WARM:
+    rc= warm_datasource();
+    break;
   }
 
 end:
@@ -846,6 +906,7 @@ int main(int argc, char **argv)
     case ACTION_LIST:
     case ACTION_ADD:
     case ACTION_REMOVE:
+    case ACTION_WARM:
       if (action)
       {
         action_usage();
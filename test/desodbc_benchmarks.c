@@ -0,0 +1,262 @@
+// Copyright (c) 2025 Sergio Miguel Garcia Jimenez <segarc21@ucm.es>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0, as
+// published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+// ---------------------------------------------------------
+// This file is part of DESODBC, an ODBC Driver of the open-source DBMS
+// Datalog Educational System (DES) (see https://des.sourceforge.io/),
+// written by Sergio Miguel Garcia Jimenez <segarc21@ucm.es>, hereinafter
+// the DESODBC developer.
+// ---------------------------------------------------------
+
+/* Benchmarks of the driver. They only print timings, so they are not part
+   of the unit tests: desodbc_benchmarks is built with them but it is not
+   registered with CTest, and it is run by hand. */
+
+#include "odbctap.h"
+#include "desodbc_test_util.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#define TEST_BUFFER_SIZE 256
+
+/* Number parsers of desodbc-util (util/stringutil.h) */
+double myodbc_strtod(const char *str, int len);
+size_t myodbc_strtod_batch(const char *const *values,
+                           const unsigned long *lengths, size_t count,
+                           double *out, char *converted);
+
+/* Average round trip of a short lookup */
+DECLARE_TEST(query_latency) {
+#define LATENCY_ITERATIONS 100
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS tabletest");
+
+  ok_sql(hstmt, "CREATE TABLE tabletest (id INT PRIMARY KEY, name VARCHAR(20))");
+
+  ok_sql(hstmt, "INSERT INTO tabletest VALUES (1,'foo')");
+
+  double start = now_us();
+  for (int i = 0; i < LATENCY_ITERATIONS; ++i) {
+    ok_sql(hstmt, "SELECT name FROM tabletest WHERE id = 1");
+    ok_stmt(hstmt, SQLFetch(hstmt));
+    ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+  }
+  double elapsed = now_us() - start;
+
+  printMessage("average query latency: %.1f us",
+               elapsed / LATENCY_ITERATIONS);
+
+  return OK;
+}
+
+/* Time taken to parse a column of floats one by one and in a batch */
+DECLARE_TEST(number_parsing_benchmark) {
+#define PARSING_ROUNDS 20
+  static char texts[NUMBERS_COUNT][NUMBER_LENGTH];
+  static const char *values[NUMBERS_COUNT];
+  static unsigned long lengths[NUMBERS_COUNT];
+  static double doubles[NUMBERS_COUNT];
+  static char converted[NUMBERS_COUNT];
+  double start, one_by_one, batch, sum = 0;
+  int round;
+  size_t i;
+
+  for (i = 0; i < NUMBERS_COUNT; ++i) {
+    char *p = random_digits(texts[i], 1 + next_random() % 6);
+    *p++ = '.';
+    random_digits(p, 1 + next_random() % 4);
+    values[i] = texts[i];
+    lengths[i] = (unsigned long)strlen(texts[i]);
+  }
+
+  start = now_us();
+  for (round = 0; round < PARSING_ROUNDS; ++round)
+    for (i = 0; i < NUMBERS_COUNT; ++i)
+      sum += myodbc_strtod(values[i], (int)lengths[i]);
+  one_by_one = now_us() - start;
+
+  start = now_us();
+  for (round = 0; round < PARSING_ROUNDS; ++round) {
+    myodbc_strtod_batch(values, lengths, NUMBERS_COUNT, doubles, converted);
+    sum += doubles[round];
+  }
+  batch = now_us() - start;
+
+  is(sum != 0);
+  printMessage("float parsing: %.1f ns/value one by one, %.1f ns/value batch",
+               one_by_one * 1000 / (PARSING_ROUNDS * NUMBERS_COUNT),
+               batch * 1000 / (PARSING_ROUNDS * NUMBERS_COUNT));
+
+  return OK;
+}
+
+/* Time taken to fetch a text column as SQL_C_CHAR and as SQL_C_WCHAR */
+DECLARE_TEST(wide_fetch_benchmark) {
+#define WIDE_ROWS 200
+#define WIDE_ROUNDS 20
+  static char insert[WIDE_ROWS * 128];
+  char narrow[256];
+  SQLWCHAR wide[256];
+  double elapsed[2] = {0, 0};
+  int mode, round, rows;
+  size_t used;
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS tabletest");
+
+  ok_sql(hstmt,
+         "CREATE TABLE tabletest (id INT PRIMARY KEY, name VARCHAR(100))");
+
+  used = sprintf(insert, "INSERT INTO tabletest VALUES ");
+  for (rows = 0; rows < WIDE_ROWS; ++rows)
+    used += sprintf(insert + used, "%s(%d,'row %d of the wide fetch "
+                    "benchmark, which is long enough to be worth it')",
+                    rows ? "," : "", rows, rows);
+  ok_stmt(hstmt, SQLExecDirect(hstmt, (SQLCHAR *)insert, SQL_NTS));
+
+  for (round = 0; round < WIDE_ROUNDS; ++round) {
+    for (mode = 0; mode < 2; ++mode) {
+      double start;
+      ok_sql(hstmt, "SELECT name FROM tabletest");
+
+      start = now_us();
+      for (rows = 0; SQLFetch(hstmt) == SQL_SUCCESS; ++rows) {
+        if (mode == 0)
+          ok_stmt(hstmt, SQLGetData(hstmt, 1, SQL_C_CHAR, narrow,
+                                    sizeof(narrow), NULL));
+        else
+          ok_stmt(hstmt, SQLGetData(hstmt, 1, SQL_C_WCHAR, wide,
+                                    sizeof(wide), NULL));
+      }
+      elapsed[mode] += now_us() - start;
+
+      is_num(rows, WIDE_ROWS);
+      ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+    }
+  }
+
+  printMessage("text fetch: %.1f us/row as SQL_C_CHAR, %.1f us/row as "
+               "SQL_C_WCHAR",
+               elapsed[0] / (WIDE_ROUNDS * WIDE_ROWS),
+               elapsed[1] / (WIDE_ROUNDS * WIDE_ROWS));
+
+  return OK;
+}
+
+/* Tail latency of concurrent connections: each thread runs short lookups
+   on its own connection, so that they wait for the query mutex of the same
+   DES process. */
+#define CONTENTION_THREADS 4
+#define CONTENTION_ITERATIONS 50
+
+typedef struct {
+  SQLHSTMT hstmt;
+  double times[CONTENTION_ITERATIONS];
+  int failed;
+} contention_worker_data;
+
+#ifdef _WIN32
+static DWORD WINAPI contention_worker(LPVOID arg)
+#else
+static void *contention_worker(void *arg)
+#endif
+{
+  contention_worker_data *data = (contention_worker_data *)arg;
+  int i;
+
+  for (i = 0; i < CONTENTION_ITERATIONS; ++i) {
+    double start = now_us();
+    SQLRETURN rc = SQLExecDirect(
+        data->hstmt, (SQLCHAR *)"SELECT name FROM tabletest WHERE id = 1",
+        SQL_NTS);
+    if (SQL_SUCCEEDED(rc)) rc = SQLFetch(data->hstmt);
+    SQLFreeStmt(data->hstmt, SQL_CLOSE);
+    data->times[i] = now_us() - start;
+    if (!SQL_SUCCEEDED(rc)) data->failed = 1;
+  }
+  return 0;
+}
+
+static int compare_times(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+DECLARE_TEST(query_mutex_contention) {
+  SQLHENV henvs[CONTENTION_THREADS];
+  SQLHDBC hdbcs[CONTENTION_THREADS];
+  contention_worker_data data[CONTENTION_THREADS];
+  double times[CONTENTION_THREADS * CONTENTION_ITERATIONS];
+  SQLHSTMT hstmt1;
+  SQLCHAR conn[TEST_BUFFER_SIZE];
+  int i;
+#ifdef _WIN32
+  HANDLE threads[CONTENTION_THREADS];
+#else
+  pthread_t threads[CONTENTION_THREADS];
+#endif
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS tabletest");
+  ok_sql(hstmt, "CREATE TABLE tabletest (id INT PRIMARY KEY, name VARCHAR(20))");
+  ok_sql(hstmt, "INSERT INTO tabletest VALUES (1,'foo')");
+
+  snprintf((char *)conn, sizeof(conn), "DSN=%s", (char *)mydsn);
+  for (i = 0; i < CONTENTION_THREADS; ++i) {
+    is(mydrvconnect(&henvs[i], &hdbcs[i], &hstmt1, conn) == OK);
+    data[i].hstmt = hstmt1;
+    data[i].failed = 0;
+  }
+
+  for (i = 0; i < CONTENTION_THREADS; ++i) {
+#ifdef _WIN32
+    threads[i] = CreateThread(NULL, 0, contention_worker, &data[i], 0, NULL);
+    is(threads[i] != NULL);
+#else
+    is(pthread_create(&threads[i], NULL, contention_worker, &data[i]) == 0);
+#endif
+  }
+
+  for (i = 0; i < CONTENTION_THREADS; ++i) {
+#ifdef _WIN32
+    WaitForSingleObject(threads[i], INFINITE);
+    CloseHandle(threads[i]);
+#else
+    pthread_join(threads[i], NULL);
+#endif
+    is_num(data[i].failed, 0);
+    memcpy(times + i * CONTENTION_ITERATIONS, data[i].times,
+           sizeof(data[i].times));
+    free_basic_handles(&henvs[i], &hdbcs[i], &data[i].hstmt);
+  }
+
+  qsort(times, CONTENTION_THREADS * CONTENTION_ITERATIONS, sizeof(double),
+        compare_times);
+  printMessage("contended query latency: p50 %.1f us, p99 %.1f us",
+               times[CONTENTION_THREADS * CONTENTION_ITERATIONS / 2],
+               times[CONTENTION_THREADS * CONTENTION_ITERATIONS * 99 / 100]);
+
+  return OK;
+}
+
+BEGIN_TESTS
+ADD_TEST(query_latency)
+ADD_TEST(number_parsing_benchmark)
+ADD_TEST(wide_fetch_benchmark)
+ADD_TEST(query_mutex_contention)
+END_TESTS
+
+
+RUN_TESTS
@@ -0,0 +1,70 @@
+// Copyright (c) 2025 Sergio Miguel Garcia Jimenez <segarc21@ucm.es>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0, as
+// published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+// ---------------------------------------------------------
+// This file is part of DESODBC, an ODBC Driver of the open-source DBMS
+// Datalog Educational System (DES) (see https://des.sourceforge.io/),
+// written by Sergio Miguel Garcia Jimenez <segarc21@ucm.es>, hereinafter
+// the DESODBC developer.
+// ---------------------------------------------------------
+
+/* Helpers shared by the unit tests and the benchmarks of DESODBC */
+
+#ifndef DESODBC_TEST_UTIL_H
+#define DESODBC_TEST_UTIL_H
+
+#ifndef _WIN32
+#include <sys/time.h>
+#endif
+
+/* Connection attributes of the driver (see driver/driver.h) */
+#define DES_DRIVER_CONNECT_ATTR_BASE 0x00004000
+#define DES_ATTR_SAVE_SNAPSHOT DES_DRIVER_CONNECT_ATTR_BASE + 0x00002000
+#define DES_ATTR_CONNECT_TIME DES_DRIVER_CONNECT_ATTR_BASE + 0x00002001
+#define DES_ATTR_LAUNCH_TIME DES_DRIVER_CONNECT_ATTR_BASE + 0x00002002
+
+/* Wall-clock time in microseconds, used by the latency benchmarks. */
+static inline double now_us() {
+#ifdef _WIN32
+  LARGE_INTEGER freq, counter;
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&counter);
+  return (double)counter.QuadPart * 1000000.0 / (double)freq.QuadPart;
+#else
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double)tv.tv_sec * 1000000.0 + (double)tv.tv_usec;
+#endif
+}
+
+#define NUMBERS_COUNT 20000
+#define NUMBER_LENGTH 40
+
+/* Deterministic pseudo-random numbers for the number parsing tests and
+   benchmarks */
+static unsigned int number_seed = 12345;
+static inline unsigned int next_random() {
+  number_seed = number_seed * 1103515245 + 12345;
+  return (number_seed >> 8) & 0xFFFFFF;
+}
+
+/* Writes n random digits into buffer, returning where they end */
+static inline char *random_digits(char *buffer, int n) {
+  for (int i = 0; i < n; ++i) *buffer++ = '0' + next_random() % 10;
+  *buffer = '\0';
+  return buffer;
+}
+
+#endif /* DESODBC_TEST_UTIL_H */
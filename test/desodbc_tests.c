@@ -36,9 +36,26 @@
 // ---------------------------------------------------------
 
 #include "odbctap.h"
+#include "desodbc_test_util.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 #define TEST_BUFFER_SIZE 256
 
+/* Number parsers of desodbc-util (util/stringutil.h) */
+double myodbc_strtod(const char *str, int len);
+size_t myodbc_strtoll_batch(const char *const *values,
+                            const unsigned long *lengths, size_t count,
+                            long long *out, char *converted);
+size_t myodbc_strtod_batch(const char *const *values,
+                           const unsigned long *lengths, size_t count,
+                           double *out, char *converted);
+
 DECLARE_TEST(simple_select_standard)
 {
   ok_sql(hstmt, "DROP TABLE IF EXISTS tabletest");
@@ -131,6 +148,90 @@ DECLARE_TEST(simple_select_block) {
   return OK;
 }
 
+DECLARE_TEST(typed_block_fetch) {
+#define TYPED_BLOCK_SIZE 3
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS tabletest");
+
+  ok_sql(hstmt, "CREATE TABLE tabletest (id INT PRIMARY KEY, val FLOAT)");
+
+  ok_sql(hstmt, "INSERT INTO tabletest VALUES (1,1.5),(2,NULL),(3,-2.25)");
+
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_ROW_ARRAY_SIZE,
+                                (SQLPOINTER)TYPED_BLOCK_SIZE, 0));
+
+  SQLINTEGER ids[TYPED_BLOCK_SIZE];
+  SQLLEN ids_lens[TYPED_BLOCK_SIZE];
+  double vals[TYPED_BLOCK_SIZE];
+  SQLLEN vals_lens[TYPED_BLOCK_SIZE];
+
+  ok_sql(hstmt, "SELECT * FROM tabletest ORDER BY id");
+
+  ok_stmt(hstmt, SQLBindCol(hstmt, 1, SQL_C_SLONG, ids, 0, ids_lens));
+  ok_stmt(hstmt, SQLBindCol(hstmt, 2, SQL_C_DOUBLE, vals, 0, vals_lens));
+
+  ok_stmt(hstmt, SQLFetch(hstmt));
+
+  is_num(ids[0], 1);
+  is_num(ids_lens[0], sizeof(SQLINTEGER));
+  is(vals[0] == 1.5);
+  is_num(vals_lens[0], sizeof(double));
+
+  is_num(ids[1], 2);
+  is_num(vals_lens[1], SQL_NULL_DATA);
+
+  is_num(ids[2], 3);
+  is(vals[2] == -2.25);
+
+  return OK;
+}
+
+/* Chunked retrieval of a string as SQL_C_WCHAR */
+DECLARE_TEST(wide_chunked_getdata) {
+#define WIDE_CHUNK 16
+  const wchar_t *expected = L"0123456789abcdefghijklmnopqrstuvwxyzABCD";
+  SQLWCHAR buffer[WIDE_CHUNK];
+  SQLLEN len;
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS tabletest");
+
+  ok_sql(hstmt, "CREATE TABLE tabletest (id INT PRIMARY KEY, name VARCHAR(60))");
+
+  ok_sql(hstmt, "INSERT INTO tabletest VALUES "
+                "(1,'0123456789abcdefghijklmnopqrstuvwxyzABCD')");
+
+  ok_sql(hstmt, "SELECT name FROM tabletest");
+
+  ok_stmt(hstmt, SQLFetch(hstmt));
+
+  /* Each call fills the buffer but for its terminator */
+  expect_stmt(hstmt, SQLGetData(hstmt, 1, SQL_C_WCHAR, buffer, sizeof(buffer),
+                                &len),
+              SQL_SUCCESS_WITH_INFO);
+  is_num(len, 40 * sizeof(SQLWCHAR));
+  is_wstr(sqlwchar_to_wchar_t(buffer), (wchar_t *)expected, WIDE_CHUNK - 1);
+
+  expect_stmt(hstmt, SQLGetData(hstmt, 1, SQL_C_WCHAR, buffer, sizeof(buffer),
+                                &len),
+              SQL_SUCCESS_WITH_INFO);
+  is_num(len, 25 * sizeof(SQLWCHAR));
+  is_wstr(sqlwchar_to_wchar_t(buffer), (wchar_t *)expected + 15,
+          WIDE_CHUNK - 1);
+
+  ok_stmt(hstmt, SQLGetData(hstmt, 1, SQL_C_WCHAR, buffer, sizeof(buffer),
+                            &len));
+  is_num(len, 10 * sizeof(SQLWCHAR));
+  is_wstr(sqlwchar_to_wchar_t(buffer), (wchar_t *)expected + 30, 11);
+
+  expect_stmt(hstmt, SQLGetData(hstmt, 1, SQL_C_WCHAR, buffer, sizeof(buffer),
+                                &len),
+              SQL_NO_DATA);
+
+  ok_stmt(hstmt, SQLCloseCursor(hstmt));
+
+  return OK;
+}
+
 DECLARE_TEST(parameter_binding) {
   ok_sql(hstmt, "DROP TABLE IF EXISTS tabletest");
 
@@ -163,6 +264,66 @@ DECLARE_TEST(parameter_binding) {
   return OK;
 }
 
+/* Arrays of parameters, both for INSERT (sent to DES as one batch) and for
+   UPDATE (sent query by query) */
+DECLARE_TEST(parameter_arrays) {
+  SQLINTEGER ids[3] = {1, 2, 3};
+  SQLCHAR names[3][TEST_BUFFER_SIZE] = {"foo", "bar", "baz"};
+  SQLLEN names_len[3] = {SQL_NTS, SQL_NTS, SQL_NTS};
+  SQLUSMALLINT status[3];
+  SQLULEN processed = 0;
+  int i;
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS tabletest");
+  ok_sql(hstmt, "CREATE TABLE tabletest (id INT PRIMARY KEY, name VARCHAR(20))");
+
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)3,
+                                0));
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_PARAM_STATUS_PTR, status, 0));
+  ok_stmt(hstmt,
+          SQLSetStmtAttr(hstmt, SQL_ATTR_PARAMS_PROCESSED_PTR, &processed, 0));
+
+  ok_stmt(hstmt, SQLPrepare(hstmt, "INSERT INTO tabletest VALUES (?, ?)",
+                            SQL_NTS));
+  ok_stmt(hstmt, SQLBindParameter(hstmt, 1, SQL_PARAM_INPUT, SQL_C_LONG,
+                                  SQL_INTEGER, 0, 0, ids, 0, NULL));
+  ok_stmt(hstmt, SQLBindParameter(hstmt, 2, SQL_PARAM_INPUT, SQL_C_CHAR,
+                                  SQL_VARCHAR, 20, 0, names, TEST_BUFFER_SIZE,
+                                  names_len));
+  ok_stmt(hstmt, SQLExecute(hstmt));
+  is_num(processed, 3);
+  for (i = 0; i < 3; ++i) is_num(status[i], SQL_PARAM_SUCCESS);
+
+  strcpy((char *)names[0], "qux");
+  strcpy((char *)names[1], "quux");
+  strcpy((char *)names[2], "corge");
+  ok_stmt(hstmt, SQLPrepare(hstmt,
+                            "UPDATE tabletest SET name = ? WHERE id = ?",
+                            SQL_NTS));
+  ok_stmt(hstmt, SQLBindParameter(hstmt, 1, SQL_PARAM_INPUT, SQL_C_CHAR,
+                                  SQL_VARCHAR, 20, 0, names, TEST_BUFFER_SIZE,
+                                  names_len));
+  ok_stmt(hstmt, SQLBindParameter(hstmt, 2, SQL_PARAM_INPUT, SQL_C_LONG,
+                                  SQL_INTEGER, 0, 0, ids, 0, NULL));
+  ok_stmt(hstmt, SQLExecute(hstmt));
+  is_num(processed, 3);
+  for (i = 0; i < 3; ++i) is_num(status[i], SQL_PARAM_SUCCESS);
+
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_RESET_PARAMS));
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)1,
+                                0));
+
+  ok_sql(hstmt, "SELECT name FROM tabletest WHERE id = 3");
+  ok_stmt(hstmt, SQLFetch(hstmt));
+  SQLCHAR buffer[TEST_BUFFER_SIZE];
+  ok_stmt(hstmt, SQLGetData(hstmt, 1, SQL_C_CHAR, buffer, TEST_BUFFER_SIZE,
+                            NULL));
+  is_str(buffer, "corge", 5);
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+
+  return OK;
+}
+
 DECLARE_TEST(application_variables) {
   ok_sql(hstmt, "DROP TABLE IF EXISTS tabletest");
 
@@ -223,6 +384,140 @@ DECLARE_TEST(type_conversion) {
   return OK;
 }
 
+/* Temporal values as DES prints them, fetched into the ODBC structs */
+DECLARE_TEST(temporal_fetch) {
+  SQL_DATE_STRUCT date;
+  SQL_TIME_STRUCT time;
+  SQL_TIMESTAMP_STRUCT timestamp;
+
+  ok_sql(hstmt, "create or replace table events(d date, t time, dt datetime)");
+  ok_sql(hstmt,
+         "insert into events values(cast(\'2025-02-13\' as date), "
+         "cast(\'07:45:30\' as time), "
+         "cast(\'2024-12-31 23:59:58\' as datetime))");
+  ok_sql(hstmt, "select * from events");
+
+  ok_stmt(hstmt, SQLFetch(hstmt));
+
+  ok_stmt(hstmt, SQLGetData(hstmt, 1, SQL_C_TYPE_DATE, &date, 0, NULL));
+  is_num(date.year, 2025);
+  is_num(date.month, 2);
+  is_num(date.day, 13);
+
+  ok_stmt(hstmt, SQLGetData(hstmt, 2, SQL_C_TYPE_TIME, &time, 0, NULL));
+  is_num(time.hour, 7);
+  is_num(time.minute, 45);
+  is_num(time.second, 30);
+
+  ok_stmt(hstmt, SQLGetData(hstmt, 3, SQL_C_TYPE_TIMESTAMP, &timestamp, 0,
+                            NULL));
+  is_num(timestamp.year, 2024);
+  is_num(timestamp.month, 12);
+  is_num(timestamp.day, 31);
+  is_num(timestamp.hour, 23);
+  is_num(timestamp.minute, 59);
+  is_num(timestamp.second, 58);
+  is_num(timestamp.fraction, 0);
+
+  ok_stmt(hstmt, SQLCloseCursor(hstmt));
+
+  return OK;
+}
+
+/* Integer, float and date/datetime cells are decoded into native values
+   when the result is built (see Column::decode_rows), and fetched from
+   there into matching C types. NULLs are not decoded. Every cell must give
+   the same value as converting its text does. */
+#define TYPED_ROWS 30
+
+DECLARE_TEST(typed_decoding) {
+  SQLINTEGER ints[TYPED_ROWS];
+  SQLLEN ints_lens[TYPED_ROWS];
+  double doubles[TYPED_ROWS];
+  SQLLEN doubles_lens[TYPED_ROWS];
+  SQL_TIMESTAMP_STRUCT stamps[TYPED_ROWS];
+  SQLLEN stamps_lens[TYPED_ROWS];
+  SQLCHAR insert[TEST_BUFFER_SIZE], text[TEST_BUFFER_SIZE];
+  SQLLEN text_len;
+  int i;
+
+  ok_sql(hstmt, "create or replace table typedtest(id int, i int, f float, "
+                "dt datetime)");
+  for (i = 0; i < TYPED_ROWS; ++i) {
+    /* Every third row is NULL */
+    if (i % 3 == 2)
+      snprintf((char *)insert, sizeof(insert),
+               "insert into typedtest values(%d, null, null, null)", i);
+    else
+      snprintf((char *)insert, sizeof(insert),
+               "insert into typedtest values(%d, %d, %d.25, "
+               "cast('2024-02-%02d 12:34:%02d' as datetime))",
+               i, i * 1000 - 7000, i - 10, i % 28 + 1, i);
+    ok_stmt(hstmt, SQLExecDirect(hstmt, insert, SQL_NTS));
+  }
+
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_ROW_ARRAY_SIZE,
+                                (SQLPOINTER)TYPED_ROWS, 0));
+  ok_sql(hstmt, "select i, f, dt from typedtest order by id");
+  ok_stmt(hstmt, SQLBindCol(hstmt, 1, SQL_C_SLONG, ints, 0, ints_lens));
+  ok_stmt(hstmt, SQLBindCol(hstmt, 2, SQL_C_DOUBLE, doubles, 0, doubles_lens));
+  ok_stmt(hstmt, SQLBindCol(hstmt, 3, SQL_C_TYPE_TIMESTAMP, stamps, 0,
+                            stamps_lens));
+  ok_stmt(hstmt, SQLFetch(hstmt));
+
+  for (i = 0; i < TYPED_ROWS; ++i) {
+    if (i % 3 == 2) {
+      is_num(ints_lens[i], SQL_NULL_DATA);
+      is_num(doubles_lens[i], SQL_NULL_DATA);
+      is_num(stamps_lens[i], SQL_NULL_DATA);
+      continue;
+    }
+    is_num(ints[i], i * 1000 - 7000);
+    is_num(ints_lens[i], sizeof(SQLINTEGER));
+    is(doubles[i] == (i - 10) + (i < 10 ? -0.25 : 0.25));
+    is_num(doubles_lens[i], sizeof(double));
+    is_num(stamps[i].year, 2024);
+    is_num(stamps[i].month, 2);
+    is_num(stamps[i].day, i % 28 + 1);
+    is_num(stamps[i].hour, 12);
+    is_num(stamps[i].minute, 34);
+    is_num(stamps[i].second, i);
+    is_num(stamps[i].fraction, 0);
+    is_num(stamps_lens[i], sizeof(SQL_TIMESTAMP_STRUCT));
+  }
+
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_UNBIND));
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_ROW_ARRAY_SIZE,
+                                (SQLPOINTER)1, 0));
+
+  /* The decoded values agree with the text of the cells */
+  ok_sql(hstmt, "select i, f, dt from typedtest where id = 1");
+  ok_stmt(hstmt, SQLFetch(hstmt));
+  ok_stmt(hstmt, SQLGetData(hstmt, 1, SQL_C_CHAR, text, sizeof(text),
+                            &text_len));
+  is_str(text, "-6000", 5);
+  ok_stmt(hstmt, SQLGetData(hstmt, 1, SQL_C_SLONG, ints, 0, NULL));
+  is_num(ints[0], -6000);
+  ok_stmt(hstmt, SQLGetData(hstmt, 2, SQL_C_CHAR, text, sizeof(text),
+                            &text_len));
+  is(atof((char *)text) == -9.25);
+  ok_stmt(hstmt, SQLGetData(hstmt, 2, SQL_C_DOUBLE, doubles, 0, NULL));
+  is(doubles[0] == -9.25);
+  ok_stmt(hstmt, SQLGetData(hstmt, 3, SQL_C_CHAR, text, sizeof(text),
+                            &text_len));
+  is_str(text, "2024-02-02 12:34:01", 19);
+  ok_stmt(hstmt, SQLGetData(hstmt, 3, SQL_C_TYPE_TIMESTAMP, stamps, 0,
+                            NULL));
+  is_num(stamps[0].day, 2);
+  is_num(stamps[0].second, 1);
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+
+  ok_sql(hstmt, "drop table typedtest");
+
+  return OK;
+}
+
 DECLARE_TEST(sqlcolumns) {
   ok_sql(hstmt, "DROP TABLE IF EXISTS tabletest");
 
@@ -835,12 +1130,750 @@ DECLARE_TEST(obtain_info) {
   return OK;
 }
 
+/* A value as the TAPI prints it. A few have more digits than the batch
+   parsers take, or are not numbers at all, so that they are left to the
+   current parsers. */
+static void random_number(char *buffer, int is_float) {
+  char *p = buffer;
+  if (next_random() % 3 == 0) *p++ = '-';
+  p = random_digits(p, 1 + next_random() % (next_random() % 8 ? 10 : 19));
+  if (is_float) {
+    if (next_random() % 4) {
+      *p++ = '.';
+      p = random_digits(p, 1 + next_random() % 9);
+    }
+    if (next_random() % 5 == 0)
+      sprintf(p, "e%s%u", next_random() % 2 ? "-" : "", next_random() % 40);
+  }
+  if (next_random() % 50 == 0) strcpy(buffer, "1,5");
+}
+
+/* The batch parsers must give exactly what the current ones do for every
+   value they convert */
+DECLARE_TEST(batch_number_parsing) {
+  static char texts[NUMBERS_COUNT][NUMBER_LENGTH];
+  static const char *values[NUMBERS_COUNT];
+  static unsigned long lengths[NUMBERS_COUNT];
+  static long long ints[NUMBERS_COUNT];
+  static double doubles[NUMBERS_COUNT];
+  static char converted[NUMBERS_COUNT];
+  size_t i, n;
+
+  for (i = 0; i < NUMBERS_COUNT; ++i) {
+    random_number(texts[i], 0);
+    values[i] = i % 100 == 0 ? NULL : texts[i];
+    lengths[i] = (unsigned long)strlen(texts[i]);
+  }
+  n = myodbc_strtoll_batch(values, lengths, NUMBERS_COUNT, ints, converted);
+  is(n > NUMBERS_COUNT / 2);
+  for (i = 0; i < NUMBERS_COUNT; ++i) {
+    if (!values[i]) is(!converted[i]);
+    if (converted[i]) is(ints[i] == strtoll(texts[i], NULL, 10));
+  }
+
+  for (i = 0; i < NUMBERS_COUNT; ++i) {
+    random_number(texts[i], 1);
+    lengths[i] = (unsigned long)strlen(texts[i]);
+  }
+  n = myodbc_strtod_batch(values, lengths, NUMBERS_COUNT, doubles, converted);
+  is(n > NUMBERS_COUNT / 2);
+  for (i = 0; i < NUMBERS_COUNT; ++i) {
+    double expected;
+    if (!converted[i]) continue;
+    expected = myodbc_strtod(texts[i], (int)lengths[i]);
+    is(memcmp(&doubles[i], &expected, sizeof(double)) == 0);
+  }
+
+  return OK;
+}
+
+/* Forward-only cursors without cache read big answers as they are fetched.
+   A cursor closed before its end must leave both connections usable. */
+DECLARE_TEST(forward_only_stream) {
+  SQLHENV henv1;
+  SQLHDBC hdbc1;
+  SQLHSTMT hstmt1;
+  SQLCHAR conn[TEST_BUFFER_SIZE];
+  SQLINTEGER count = 0;
+  int i;
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS tabletest");
+  ok_sql(hstmt, "CREATE TABLE tabletest (id INT)");
+  for (i = 0; i < 40; ++i) {
+    SQLCHAR insert[TEST_BUFFER_SIZE];
+    snprintf((char *)insert, sizeof(insert),
+             "INSERT INTO tabletest VALUES (%d)", i);
+    ok_stmt(hstmt, SQLExecDirect(hstmt, insert, SQL_NTS));
+  }
+
+  snprintf((char *)conn, sizeof(conn), "DSN=%s;NO_CACHE=1", (char *)mydsn);
+  is(mydrvconnect(&henv1, &hdbc1, &hstmt1, conn) == OK);
+
+  /* 1600 rows: more than a window */
+  ok_sql(hstmt1, "SELECT * FROM tabletest AS a, tabletest AS b");
+  for (i = 0; i < 10; ++i) ok_stmt(hstmt1, SQLFetch(hstmt1));
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+
+  ok_sql(hstmt, "SELECT * FROM tabletest");
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+
+  ok_sql(hstmt1, "SELECT * FROM tabletest AS a, tabletest AS b");
+  while (SQLFetch(hstmt1) == SQL_SUCCESS) count++;
+  is_num(count, 1600);
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+
+  free_basic_handles(&henv1, &hdbc1, &hstmt1);
+
+  return OK;
+}
+
+/* A forward-only cursor left idle in the middle of its answer gives the
+   query mutex up to the connections that wait for it, and its remaining
+   rows can still be fetched afterwards */
+DECLARE_TEST(idle_stream) {
+#ifdef _WIN32
+  skip("The query mutex of Windows can only be released by its owner");
+#else
+  SQLHENV henv1;
+  SQLHDBC hdbc1;
+  SQLHSTMT hstmt1;
+  SQLCHAR conn[TEST_BUFFER_SIZE];
+  SQLINTEGER count = 0;
+  int i;
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS tabletest");
+  ok_sql(hstmt, "CREATE TABLE tabletest (id INT)");
+  for (i = 0; i < 40; ++i) {
+    SQLCHAR insert[TEST_BUFFER_SIZE];
+    snprintf((char *)insert, sizeof(insert),
+             "INSERT INTO tabletest VALUES (%d)", i);
+    ok_stmt(hstmt, SQLExecDirect(hstmt, insert, SQL_NTS));
+  }
+
+  snprintf((char *)conn, sizeof(conn), "DSN=%s;NO_CACHE=1", (char *)mydsn);
+  is(mydrvconnect(&henv1, &hdbc1, &hstmt1, conn) == OK);
+
+  ok_sql(hstmt1, "SELECT * FROM tabletest AS a, tabletest AS b");
+  for (i = 0; i < 10; ++i, ++count) ok_stmt(hstmt1, SQLFetch(hstmt1));
+
+  /* Without giving the mutex up, this would wait for hstmt1 forever */
+  ok_sql(hstmt, "SELECT COUNT(*) FROM tabletest");
+  ok_stmt(hstmt, SQLFetch(hstmt));
+  is_num(my_fetch_int(hstmt, 1), 40);
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+
+  while (SQLFetch(hstmt1) == SQL_SUCCESS) count++;
+  is_num(count, 1600);
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+
+  free_basic_handles(&henv1, &hdbc1, &hstmt1);
+
+  return OK;
+#endif
+}
+
+/* A query that takes DES far longer than a second: the product of a
+   table of SLOW_ROWS rows with itself, four times */
+#define SLOW_ROWS 60
+#define SLOW_QUERY \
+  "SELECT COUNT(*) FROM slowtest a, slowtest b, slowtest c, slowtest d"
+
+static int create_slow_table(SQLHSTMT hstmt) {
+  char insert[TEST_BUFFER_SIZE * 4];
+  size_t used;
+  int i;
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS slowtest");
+  ok_sql(hstmt, "CREATE TABLE slowtest (id INT)");
+
+  used = sprintf(insert, "INSERT INTO slowtest VALUES ");
+  for (i = 0; i < SLOW_ROWS; ++i)
+    used += sprintf(insert + used, "%s(%d)", i ? "," : "", i);
+  ok_stmt(hstmt, SQLExecDirect(hstmt, (SQLCHAR *)insert, SQL_NTS));
+
+  return OK;
+}
+
+/* Checks that a connection still answers queries */
+static int check_slow_table(SQLHSTMT hstmt) {
+  ok_sql(hstmt, "SELECT COUNT(*) FROM slowtest");
+  ok_stmt(hstmt, SQLFetch(hstmt));
+  is_num(my_fetch_int(hstmt, 1), SLOW_ROWS);
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+
+  return OK;
+}
+
+/* A query that times out through the DES broker is interrupted, so that
+   the DES process it shares with other connections goes on */
+DECLARE_TEST(broker_cancel) {
+#ifdef _WIN32
+  skip("The DES broker is not available on Windows");
+#else
+  SQLHENV henv1, henv2;
+  SQLHDBC hdbc1, hdbc2;
+  SQLHSTMT hstmt1, hstmt2;
+  SQLCHAR conn[TEST_BUFFER_SIZE];
+
+  snprintf((char *)conn, sizeof(conn), "DSN=%s;DES_BROKER=1", (char *)mydsn);
+  is(mydrvconnect(&henv1, &hdbc1, &hstmt1, conn) == OK);
+  is(mydrvconnect(&henv2, &hdbc2, &hstmt2, conn) == OK);
+
+  is(create_slow_table(hstmt1) == OK);
+
+  ok_stmt(hstmt1, SQLSetStmtAttr(hstmt1, SQL_ATTR_QUERY_TIMEOUT, (SQLPOINTER)1,
+                                 0));
+  expect_stmt(hstmt1, SQLExecDirect(hstmt1, (SQLCHAR *)SLOW_QUERY, SQL_NTS),
+              SQL_ERROR);
+  is(check_sqlstate(hstmt1, "HYT00") == OK);
+  ok_stmt(hstmt1, SQLSetStmtAttr(hstmt1, SQL_ATTR_QUERY_TIMEOUT, (SQLPOINTER)0,
+                                 0));
+
+  /* Both connections still share the same DES */
+  is(check_slow_table(hstmt1) == OK);
+  is(check_slow_table(hstmt2) == OK);
+
+  ok_sql(hstmt1, "DROP TABLE slowtest");
+
+  free_basic_handles(&henv2, &hdbc2, &hstmt2);
+  free_basic_handles(&henv1, &hdbc1, &hstmt1);
+
+  return OK;
+#endif
+}
+
+#ifndef _WIN32
+/* A query run by a thread of query_mutex_order */
+typedef struct {
+  SQLHSTMT hstmt;
+  const char *query;
+  SQLRETURN rc;
+  int position;
+  pthread_t thread;
+} mutex_order_query;
+
+static pthread_mutex_t mutex_order_lock = PTHREAD_MUTEX_INITIALIZER;
+static int mutex_order_finished = 0;
+
+static void *run_mutex_order_query(void *arg) {
+  mutex_order_query *q = (mutex_order_query *)arg;
+
+  q->rc = SQLExecDirect(q->hstmt, (SQLCHAR *)q->query, SQL_NTS);
+  pthread_mutex_lock(&mutex_order_lock);
+  q->position = ++mutex_order_finished;
+  pthread_mutex_unlock(&mutex_order_lock);
+  if (SQL_SUCCEEDED(q->rc)) SQLFreeStmt(q->hstmt, SQL_CLOSE);
+  return NULL;
+}
+
+static int start_mutex_order_query(mutex_order_query *q, SQLHSTMT hstmt,
+                                   const char *query) {
+  q->hstmt = hstmt;
+  q->query = query;
+  q->rc = SQL_ERROR;
+  q->position = 0;
+  is(pthread_create(&q->thread, NULL, run_mutex_order_query, q) == 0);
+  return OK;
+}
+#endif
+
+/* The query mutex is handed over in the order it was asked for, and a
+   process killed while it waits for it does not keep the others waiting */
+DECLARE_TEST(query_mutex_order) {
+#ifdef _WIN32
+  skip("The query mutex of Windows is a system mutex");
+#else
+#define ORDER_WAITERS 3
+  SQLHENV henvs[ORDER_WAITERS + 1];
+  SQLHDBC hdbcs[ORDER_WAITERS + 1];
+  SQLHSTMT hstmts[ORDER_WAITERS + 1];
+  mutex_order_query holder, waiters[ORDER_WAITERS];
+  SQLCHAR conn[TEST_BUFFER_SIZE];
+  int go[2], i;
+  pid_t killed;
+  char c = 'x';
+
+  snprintf((char *)conn, sizeof(conn), "DSN=%s", (char *)mydsn);
+  for (i = 0; i <= ORDER_WAITERS; ++i)
+    is(mydrvconnect(&henvs[i], &hdbcs[i], &hstmts[i], conn) == OK);
+
+  is(create_slow_table(hstmt) == OK);
+
+  /* The waiter to kill is a copy of the last connection in a child
+     process, so that the connection itself stays valid */
+  is(pipe(go) == 0);
+  killed = fork();
+  is(killed != -1);
+  if (killed == 0) {
+    close(go[1]);
+    if (read(go[0], &c, 1) == 1)
+      SQLExecDirect(hstmts[ORDER_WAITERS],
+                    (SQLCHAR *)"SELECT COUNT(*) FROM slowtest", SQL_NTS);
+    _exit(0);
+  }
+  close(go[0]);
+
+  /* The holder keeps the query mutex until its query times out */
+  mutex_order_finished = 0;
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_QUERY_TIMEOUT, (SQLPOINTER)3,
+                                0));
+  is(start_mutex_order_query(&holder, hstmt, SLOW_QUERY) == OK);
+  usleep(500000);
+
+  /* Waiters queue in order, with the child between the first and the
+     second one */
+  is(start_mutex_order_query(&waiters[0], hstmts[0],
+                             "SELECT COUNT(*) FROM slowtest") == OK);
+  usleep(200000);
+  is(write(go[1], &c, 1) == 1);
+  usleep(200000);
+  is(start_mutex_order_query(&waiters[1], hstmts[1],
+                             "SELECT COUNT(*) FROM slowtest") == OK);
+  usleep(200000);
+  kill(killed, SIGKILL);
+  waitpid(killed, NULL, 0);
+  close(go[1]);
+  is(start_mutex_order_query(&waiters[2], hstmts[2],
+                             "SELECT COUNT(*) FROM slowtest") == OK);
+
+  pthread_join(holder.thread, NULL);
+  for (i = 0; i < ORDER_WAITERS; ++i) pthread_join(waiters[i].thread, NULL);
+
+  expect_stmt(hstmt, holder.rc, SQL_ERROR);
+  is(check_sqlstate(hstmt, "HYT00") == OK);
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_QUERY_TIMEOUT, (SQLPOINTER)0,
+                                0));
+  is_num(holder.position, 1);
+
+  /* Had the ticket of the killed child not been skipped, the waiters
+     after it would have timed out */
+  for (i = 0; i < ORDER_WAITERS; ++i) {
+    ok_stmt(hstmts[i], waiters[i].rc);
+    is_num(waiters[i].position, i + 2);
+  }
+
+  ok_sql(hstmt, "DROP TABLE slowtest");
+
+  for (i = 0; i <= ORDER_WAITERS; ++i)
+    free_basic_handles(&henvs[i], &hdbcs[i], &hstmts[i]);
+
+  return OK;
+#endif
+}
+
+DECLARE_TEST(des_process_pool) {
+  SQLHENV henv1, henv2;
+  SQLHDBC hdbc1, hdbc2;
+  SQLHSTMT hstmt1, hstmt2;
+  SQLCHAR conn[TEST_BUFFER_SIZE];
+
+  /* Each connection may get its own DES process, i.e., its own database */
+  snprintf((char *)conn, sizeof(conn), "DSN=%s;DES_POOL_SIZE=2",
+           (char *)mydsn);
+  is(mydrvconnect(&henv1, &hdbc1, &hstmt1, conn) == OK);
+  is(mydrvconnect(&henv2, &hdbc2, &hstmt2, conn) == OK);
+
+  ok_sql(hstmt1, "DROP TABLE IF EXISTS pooltest");
+  ok_sql(hstmt2, "DROP TABLE IF EXISTS pooltest");
+  ok_sql(hstmt1, "CREATE TABLE pooltest (id INT)");
+  ok_sql(hstmt1, "INSERT INTO pooltest VALUES (1)");
+
+  /* The second connection is routed to the other DES process, where the
+     table of the first one does not exist */
+  expect_sql(hstmt2, "SELECT * FROM pooltest", SQL_ERROR);
+
+  ok_sql(hstmt2, "DROP TABLE IF EXISTS pooltest2");
+  ok_sql(hstmt2, "CREATE TABLE pooltest2 (id INT)");
+  ok_sql(hstmt2, "SELECT * FROM pooltest2");
+  ok_stmt(hstmt2, SQLFreeStmt(hstmt2, SQL_CLOSE));
+  ok_sql(hstmt2, "DROP TABLE pooltest2");
+
+  ok_sql(hstmt1, "SELECT * FROM pooltest");
+  ok_stmt(hstmt1, SQLFetch(hstmt1));
+  is_num(my_fetch_int(hstmt1, 1), 1);
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+  ok_sql(hstmt1, "DROP TABLE pooltest");
+
+  free_basic_handles(&henv2, &hdbc2, &hstmt2);
+  free_basic_handles(&henv1, &hdbc1, &hstmt1);
+
+  return OK;
+}
+
+/* Milliseconds that DES took to start up for a connection, 0 if it was
+   already running */
+static SQLUINTEGER launch_time(SQLHDBC hdbc) {
+  SQLUINTEGER ms = 0;
+
+  SQLGetConnectAttr(hdbc, DES_ATTR_LAUNCH_TIME, &ms, 0, NULL);
+  return ms;
+}
+
+#ifndef _WIN32
+/* Connects with DES_LINGER to the second DES process of a pool, which has
+   no other clients, as the test connection keeps the first one busy */
+static int linger_connect(SQLHENV *henv1, SQLHDBC *hdbc1, SQLHSTMT *hstmt1,
+                          int linger) {
+  SQLCHAR conn[TEST_BUFFER_SIZE];
+
+  snprintf((char *)conn, sizeof(conn), "DSN=%s;DES_POOL_SIZE=2;DES_LINGER=%d",
+           (char *)mydsn, linger);
+  is(mydrvconnect(henv1, hdbc1, hstmt1, conn) == OK);
+  return OK;
+}
+#endif
+
+/* With DES_LINGER, a DES process left without clients keeps running, with
+   its database, for that many seconds. Connecting and disconnecting, as
+   desodbc-installer -w does, leaves it ready for the next connection. */
+DECLARE_TEST(linger_reuse) {
+#ifdef _WIN32
+  skip("DES_LINGER is not supported on Windows");
+#else
+  SQLHENV henv1;
+  SQLHDBC hdbc1;
+  SQLHSTMT hstmt1;
+
+  is(linger_connect(&henv1, &hdbc1, &hstmt1, 10) == OK);
+  ok_sql(hstmt1, "DROP TABLE IF EXISTS lingertest");
+  ok_sql(hstmt1, "CREATE TABLE lingertest (id INT)");
+  ok_sql(hstmt1, "INSERT INTO lingertest VALUES (1)");
+  free_basic_handles(&henv1, &hdbc1, &hstmt1);
+
+  is(linger_connect(&henv1, &hdbc1, &hstmt1, 10) == OK);
+  is_num(launch_time(hdbc1), 0);
+  ok_sql(hstmt1, "SELECT * FROM lingertest");
+  ok_stmt(hstmt1, SQLFetch(hstmt1));
+  is_num(my_fetch_int(hstmt1, 1), 1);
+  ok_stmt(hstmt1, SQLFreeStmt(hstmt1, SQL_CLOSE));
+  ok_sql(hstmt1, "DROP TABLE lingertest");
+  free_basic_handles(&henv1, &hdbc1, &hstmt1);
+
+  return OK;
+#endif
+}
+
+/* Once DES_LINGER seconds pass without clients, the DES process quits and
+   the next connection starts a new one, with an empty database */
+DECLARE_TEST(linger_exit) {
+#ifdef _WIN32
+  skip("DES_LINGER is not supported on Windows");
+#else
+  SQLHENV henv1;
+  SQLHDBC hdbc1;
+  SQLHSTMT hstmt1;
+
+  is(linger_connect(&henv1, &hdbc1, &hstmt1, 1) == OK);
+  ok_sql(hstmt1, "DROP TABLE IF EXISTS lingertest");
+  ok_sql(hstmt1, "CREATE TABLE lingertest (id INT)");
+  free_basic_handles(&henv1, &hdbc1, &hstmt1);
+
+  sleep(4);
+
+  is(linger_connect(&henv1, &hdbc1, &hstmt1, 1) == OK);
+  is(launch_time(hdbc1) > 0);
+  expect_sql(hstmt1, "SELECT * FROM lingertest", SQL_ERROR);
+  free_basic_handles(&henv1, &hdbc1, &hstmt1);
+
+  return OK;
+#endif
+}
+
+/* A snapshot saved through DES_ATTR_SAVE_SNAPSHOT is restored by the DES
+   process launched for a connection with DES_SNAPSHOT, also from a path
+   with blanks */
+DECLARE_TEST(snapshot_roundtrip) {
+  SQLHENV henv1, henv2;
+  SQLHDBC hdbc1, hdbc2;
+  SQLHSTMT hstmt1, hstmt2;
+  SQLCHAR conn[TEST_BUFFER_SIZE];
+  char path[TEST_BUFFER_SIZE];
+
+#ifdef _WIN32
+  snprintf(path, sizeof(path), "%s\\desodbc snapshot.sav", getenv("TEMP"));
+#else
+  snprintf(path, sizeof(path), "/tmp/desodbc snapshot.sav");
+#endif
+
+  /* The second and the third processes of the pool: neither is the one
+     of the test connection, and the third one is launched here */
+  snprintf((char *)conn, sizeof(conn), "DSN=%s;DES_POOL_SIZE=2",
+           (char *)mydsn);
+  is(mydrvconnect(&henv1, &hdbc1, &hstmt1, conn) == OK);
+
+  ok_sql(hstmt1, "DROP TABLE IF EXISTS snaptest");
+  ok_sql(hstmt1, "CREATE TABLE snaptest (id INT)");
+  ok_sql(hstmt1, "INSERT INTO snaptest VALUES (7)");
+  ok_con(hdbc1, SQLSetConnectAttr(hdbc1, DES_ATTR_SAVE_SNAPSHOT,
+                                  (SQLPOINTER)path, SQL_NTS));
+  ok_sql(hstmt1, "DROP TABLE snaptest");
+
+  snprintf((char *)conn, sizeof(conn),
+           "DSN=%s;DES_POOL_SIZE=3;DES_SNAPSHOT={%s}", (char *)mydsn, path);
+  is(mydrvconnect(&henv2, &hdbc2, &hstmt2, conn) == OK);
+  is(launch_time(hdbc2) > 0);
+
+  ok_sql(hstmt2, "SELECT * FROM snaptest");
+  ok_stmt(hstmt2, SQLFetch(hstmt2));
+  is_num(my_fetch_int(hstmt2, 1), 7);
+  ok_stmt(hstmt2, SQLFreeStmt(hstmt2, SQL_CLOSE));
+  ok_sql(hstmt2, "DROP TABLE snaptest");
+
+  free_basic_handles(&henv2, &hdbc2, &hstmt2);
+  free_basic_handles(&henv1, &hdbc1, &hstmt1);
+  remove(path);
+
+  return OK;
+}
+
+/* The connection and DES start-up times of a connection can be read, and
+   DES starting up is part of connecting */
+DECLARE_TEST(connect_times) {
+  SQLHENV henv1, henv2;
+  SQLHDBC hdbc1, hdbc2;
+  SQLHSTMT hstmt1, hstmt2;
+  SQLCHAR conn[TEST_BUFFER_SIZE];
+  SQLUINTEGER connect_ms = 0, launch_ms = 0;
+
+  /* An unsigned wrap-around of a negative time would be far greater */
+  ok_con(hdbc, SQLGetConnectAttr(hdbc, DES_ATTR_CONNECT_TIME, &connect_ms, 0,
+                                 NULL));
+  ok_con(hdbc, SQLGetConnectAttr(hdbc, DES_ATTR_LAUNCH_TIME, &launch_ms, 0,
+                                 NULL));
+  is(connect_ms < 600000);
+  is(launch_ms <= connect_ms);
+
+  /* The third process of a pool, none of whose processes is used by other
+     connections, is started by the second connection */
+  snprintf((char *)conn, sizeof(conn), "DSN=%s;DES_POOL_SIZE=2",
+           (char *)mydsn);
+  is(mydrvconnect(&henv1, &hdbc1, &hstmt1, conn) == OK);
+  snprintf((char *)conn, sizeof(conn), "DSN=%s;DES_POOL_SIZE=3",
+           (char *)mydsn);
+  is(mydrvconnect(&henv2, &hdbc2, &hstmt2, conn) == OK);
+
+  ok_con(hdbc2, SQLGetConnectAttr(hdbc2, DES_ATTR_CONNECT_TIME, &connect_ms,
+                                  0, NULL));
+  ok_con(hdbc2, SQLGetConnectAttr(hdbc2, DES_ATTR_LAUNCH_TIME, &launch_ms, 0,
+                                  NULL));
+  is(connect_ms < 600000);
+  is(launch_ms > 0);
+  is(launch_ms <= connect_ms);
+
+  free_basic_handles(&henv2, &hdbc2, &hstmt2);
+  free_basic_handles(&henv1, &hdbc1, &hstmt1);
+
+  return OK;
+}
+
+DECLARE_TEST(async_execution) {
+  SQLRETURN rc;
+  SQLULEN async_enable = 0;
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS asynctest");
+  ok_sql(hstmt, "CREATE TABLE asynctest (id INT)");
+  ok_sql(hstmt, "INSERT INTO asynctest VALUES (1)");
+
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_ASYNC_ENABLE,
+                                (SQLPOINTER)SQL_ASYNC_ENABLE_ON, 0));
+  ok_stmt(hstmt, SQLGetStmtAttr(hstmt, SQL_ATTR_ASYNC_ENABLE, &async_enable,
+                                0, NULL));
+  is_num(async_enable, SQL_ASYNC_ENABLE_ON);
+
+  /* Until the result is returned, other functions of the statement are
+     out of sequence */
+  expect_stmt(hstmt, SQLExecDirect(hstmt, (SQLCHAR *)"SELECT * FROM asynctest",
+                                   SQL_NTS),
+              SQL_STILL_EXECUTING);
+  expect_stmt(hstmt, SQLFetch(hstmt), SQL_ERROR);
+  is(check_sqlstate(hstmt, "HY010") == OK);
+
+  /* The same call is repeated until the worker has run the query */
+  while ((rc = SQLExecDirect(hstmt, (SQLCHAR *)"SELECT * FROM asynctest",
+                             SQL_NTS)) == SQL_STILL_EXECUTING)
+    ;
+  ok_stmt(hstmt, rc);
+  ok_stmt(hstmt, SQLFetch(hstmt));
+  is_num(my_fetch_int(hstmt, 1), 1);
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+
+  ok_stmt(hstmt, SQLPrepare(hstmt, (SQLCHAR *)"DROP TABLE asynctest", SQL_NTS));
+  while ((rc = SQLExecute(hstmt)) == SQL_STILL_EXECUTING)
+    ;
+  ok_stmt(hstmt, rc);
+
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_ASYNC_ENABLE,
+                                (SQLPOINTER)SQL_ASYNC_ENABLE_OFF, 0));
+
+  return OK;
+}
+
+#if !defined(_WIN32) && defined(SQL_ATTR_ASYNC_STMT_PCALLBACK)
+/* Notifications of async_notification */
+typedef struct {
+  pthread_mutex_t lock;
+  pthread_cond_t done;
+  int calls;
+} async_notice;
+
+static SQLRETURN SQL_API notify_async(SQLPOINTER context, BOOL last) {
+  async_notice *notice = (async_notice *)context;
+
+  pthread_mutex_lock(&notice->lock);
+  notice->calls++;
+  pthread_cond_signal(&notice->done);
+  pthread_mutex_unlock(&notice->lock);
+  return SQL_SUCCESS;
+}
+#endif
+
+/* In notification mode, the application is told when an asynchronous
+   execution is done instead of polling for it */
+DECLARE_TEST(async_notification) {
+  SQLRETURN rc;
+
+  ok_sql(hstmt, "DROP TABLE IF EXISTS asynctest");
+  ok_sql(hstmt, "CREATE TABLE asynctest (id INT)");
+  ok_sql(hstmt, "INSERT INTO asynctest VALUES (2)");
+
+#ifdef _WIN32
+  {
+    HANDLE event = CreateEvent(NULL, FALSE, FALSE, NULL);
+
+    ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_ASYNC_ENABLE,
+                                  (SQLPOINTER)SQL_ASYNC_ENABLE_ON, 0));
+    ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_ASYNC_STMT_EVENT, event, 0));
+    expect_stmt(hstmt,
+                SQLExecDirect(hstmt, (SQLCHAR *)"SELECT * FROM asynctest",
+                              SQL_NTS),
+                SQL_STILL_EXECUTING);
+    is(WaitForSingleObject(event, 10000) == WAIT_OBJECT_0);
+    ok_stmt(hstmt, SQLCompleteAsync(SQL_HANDLE_STMT, hstmt, &rc));
+    ok_stmt(hstmt, rc);
+
+    ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_ASYNC_STMT_EVENT, NULL, 0));
+    CloseHandle(event);
+  }
+#elif !defined(SQL_ATTR_ASYNC_STMT_PCALLBACK)
+  skip("The ODBC headers do not support notification mode");
+#else
+  {
+    /* The driver manager gives the driver its own callback for the event
+       of the application; we stand for it */
+    async_notice notice = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+                           0};
+    struct timespec deadline;
+
+    if (!SQL_SUCCEEDED(SQLSetStmtAttr(hstmt, SQL_ATTR_ASYNC_STMT_PCALLBACK,
+                                      (SQLPOINTER)notify_async, 0)) ||
+        !SQL_SUCCEEDED(SQLSetStmtAttr(hstmt, SQL_ATTR_ASYNC_STMT_PCONTEXT,
+                                      &notice, 0))) {
+      SQLSetStmtAttr(hstmt, SQL_ATTR_ASYNC_STMT_PCALLBACK, NULL, 0);
+      skip("The driver manager does not pass the notification callback on");
+    }
+
+    ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_ASYNC_ENABLE,
+                                  (SQLPOINTER)SQL_ASYNC_ENABLE_ON, 0));
+
+    expect_stmt(hstmt,
+                SQLExecDirect(hstmt, (SQLCHAR *)"SELECT * FROM asynctest",
+                              SQL_NTS),
+                SQL_STILL_EXECUTING);
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += 10;
+    pthread_mutex_lock(&notice.lock);
+    while (notice.calls == 0 &&
+           pthread_cond_timedwait(&notice.done, &notice.lock, &deadline) == 0)
+      ;
+    pthread_mutex_unlock(&notice.lock);
+    is_num(notice.calls, 1);
+
+    /* Once notified, the call is repeated to get the result */
+    rc = SQLExecDirect(hstmt, (SQLCHAR *)"SELECT * FROM asynctest", SQL_NTS);
+    ok_stmt(hstmt, rc);
+
+    ok_stmt(hstmt,
+            SQLSetStmtAttr(hstmt, SQL_ATTR_ASYNC_STMT_PCALLBACK, NULL, 0));
+    ok_stmt(hstmt,
+            SQLSetStmtAttr(hstmt, SQL_ATTR_ASYNC_STMT_PCONTEXT, NULL, 0));
+  }
+#endif
+
+  ok_stmt(hstmt, SQLFetch(hstmt));
+  is_num(my_fetch_int(hstmt, 1), 2);
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_ASYNC_ENABLE,
+                                (SQLPOINTER)SQL_ASYNC_ENABLE_OFF, 0));
+  ok_sql(hstmt, "DROP TABLE asynctest");
+
+  return OK;
+}
+
+DECLARE_TEST(query_timeout) {
+  SQLULEN timeout = 0;
+
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_QUERY_TIMEOUT, (SQLPOINTER)5,
+                                0));
+  ok_stmt(hstmt, SQLGetStmtAttr(hstmt, SQL_ATTR_QUERY_TIMEOUT, &timeout, 0,
+                                NULL));
+  is_num(timeout, 5);
+
+  /* Queries that end in time are not affected */
+  ok_sql(hstmt, "DROP TABLE IF EXISTS timeouttest");
+  ok_sql(hstmt, "CREATE TABLE timeouttest (id INT)");
+  ok_sql(hstmt, "INSERT INTO timeouttest VALUES (1)");
+  ok_sql(hstmt, "SELECT * FROM timeouttest");
+  ok_stmt(hstmt, SQLFetch(hstmt));
+  is_num(my_fetch_int(hstmt, 1), 1);
+  ok_stmt(hstmt, SQLFreeStmt(hstmt, SQL_CLOSE));
+  ok_sql(hstmt, "DROP TABLE timeouttest");
+
+  /* Nothing to cancel: the cursor is just closed */
+  ok_stmt(hstmt, SQLCancel(hstmt));
+
+  /* A query that does not end in time is abandoned, and DES goes on
+     answering this connection and the other ones that share it */
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_QUERY_TIMEOUT, (SQLPOINTER)0,
+                                0));
+  is(create_slow_table(hstmt) == OK);
+
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_QUERY_TIMEOUT, (SQLPOINTER)1,
+                                0));
+  expect_stmt(hstmt, SQLExecDirect(hstmt, (SQLCHAR *)SLOW_QUERY, SQL_NTS),
+              SQL_ERROR);
+  is(check_sqlstate(hstmt, "HYT00") == OK);
+
+  ok_stmt(hstmt, SQLSetStmtAttr(hstmt, SQL_ATTR_QUERY_TIMEOUT, (SQLPOINTER)0,
+                                0));
+  is(check_slow_table(hstmt) == OK);
+
+  SQLHENV henv2;
+  SQLHDBC hdbc2;
+  SQLHSTMT hstmt2;
+  SQLCHAR conn[TEST_BUFFER_SIZE];
+  snprintf((char *)conn, sizeof(conn), "DSN=%s", (char *)mydsn);
+  is(mydrvconnect(&henv2, &hdbc2, &hstmt2, conn) == OK);
+  is(check_slow_table(hstmt2) == OK);
+  free_basic_handles(&henv2, &hdbc2, &hstmt2);
+
+  ok_sql(hstmt, "DROP TABLE slowtest");
+
+  return OK;
+}
+
 BEGIN_TESTS
 ADD_TEST(simple_select_standard)
 ADD_TEST(simple_select_block)
+ADD_TEST(typed_block_fetch)
+ADD_TEST(wide_chunked_getdata)
 ADD_TEST(parameter_binding)
+ADD_TEST(parameter_arrays)
 ADD_TEST(application_variables)
 ADD_TEST(type_conversion)
+ADD_TEST(temporal_fetch)
+ADD_TEST(typed_decoding)
 ADD_TEST(sqlcolumns)
 ADD_TEST(sqlgettypeinfo)
 ADD_TEST(sqlprimarykeys)
@@ -856,6 +1889,19 @@ ADD_TEST(sqldisconnect)
 ADD_TEST(sqlfreehandle)
 ADD_TEST(error_handling)
 ADD_TEST(obtain_info)
+ADD_TEST(batch_number_parsing)
+ADD_TEST(forward_only_stream)
+ADD_TEST(idle_stream)
+ADD_TEST(des_process_pool)
+ADD_TEST(linger_reuse)
+ADD_TEST(linger_exit)
+ADD_TEST(snapshot_roundtrip)
+ADD_TEST(connect_times)
+ADD_TEST(query_mutex_order)
+ADD_TEST(broker_cancel)
+ADD_TEST(async_execution)
+ADD_TEST(async_notification)
+ADD_TEST(query_timeout)
 END_TESTS
 
 
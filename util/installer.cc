@@ -107,6 +107,26 @@ static SQLWCHAR W_DES_EXEC[] = {'D', 'E', 'S', '_', 'E', 'X', 'E', 'C', 0};
 */
 static SQLWCHAR W_DES_WORKING_DIR[] = {'D', 'E', 'S', '_', 'W', 'O', 'R', 'K', 'I', 'N', 'G', '_', 'D', 'I', 'R', 0};
 
+/* DESODBC:
+    Original author: DESODBC Developer
+*/
+static SQLWCHAR W_DES_POOL_SIZE[] = {'D', 'E', 'S', '_', 'P', 'O', 'O', 'L', '_', 'S', 'I', 'Z', 'E', 0};
+
+/* DESODBC:
+    Original author: DESODBC Developer
+*/
+static SQLWCHAR W_DES_LINGER[] = {'D', 'E', 'S', '_', 'L', 'I', 'N', 'G', 'E', 'R', 0};
+
+/* DESODBC:
+    Original author: DESODBC Developer
+*/
+static SQLWCHAR W_DES_SNAPSHOT[] = {'D', 'E', 'S', '_', 'S', 'N', 'A', 'P', 'S', 'H', 'O', 'T', 0};
+
+/* DESODBC:
+    Original author: DESODBC Developer
+*/
+static SQLWCHAR W_DES_BROKER[] = {'D', 'E', 'S', '_', 'B', 'R', 'O', 'K', 'E', 'R', 0};
+
 static SQLWCHAR W_UID[]= {'U', 'I', 'D', 0};
 static SQLWCHAR W_USER[]= {'U', 'S', 'E', 'R', 0};
 static SQLWCHAR W_PWD[]= {'P', 'W', 'D', 0};
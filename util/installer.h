@@ -286,7 +286,7 @@ class Driver {
 
 #define STR_OPTIONS_LIST(X)                                                \
   X(DSN)                                                                   \
-  X(DRIVER) X(DESCRIPTION) X(DES_EXEC) X(DES_WORKING_DIR) X(UID) X(PWD) MFA_OPTS(X) X(DATABASE) \
+  X(DRIVER) X(DESCRIPTION) X(DES_EXEC) X(DES_WORKING_DIR) X(DES_SNAPSHOT) X(UID) X(PWD) MFA_OPTS(X) X(DATABASE) \
       X(SOCKET) X(INITSTMT) X(CHARSET) X(SSL_KEY) X(SSL_CERT) X(SSL_CA)    \
           X(SSL_CAPATH) X(SSL_CIPHER) X(SSL_MODE) X(RSAKEY) X(SAVEFILE)    \
               X(PLUGIN_DIR) X(DEFAULT_AUTH) X(LOAD_DATA_LOCAL_DIR)         \
@@ -298,7 +298,7 @@ class Driver {
 #define INT_OPTIONS_LIST(X)                                         \
   X(PORT)                                                           \
   X(READTIMEOUT) X(WRITETIMEOUT) X(CLIENT_INTERACTIVE)              \
-      X(PREFETCH)
+      X(PREFETCH) X(DES_POOL_SIZE) X(DES_LINGER)
 
 // TODO: remove AUTO_RECONNECT when special handling (warning)
 //       is not needed anymore.
@@ -316,7 +316,8 @@ class Driver {
                                   X(NO_TLS_1_2) X(NO_TLS_1_3)                  \
                                       X(NO_DATE_OVERFLOW)                      \
                                           X(ENABLE_LOCAL_INFILE)               \
-                                              X(ENABLE_DNS_SRV) X(MULTI_HOST)
+                                              X(ENABLE_DNS_SRV) X(MULTI_HOST)  \
+                                                  X(DES_BROKER)
 
 #define FULL_OPTIONS_LIST(X) \
   STR_OPTIONS_LIST(X) INT_OPTIONS_LIST(X) BOOL_OPTIONS_LIST(X)
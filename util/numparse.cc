@@ -0,0 +1,387 @@
+// Copyright (c) 2025 Sergio Miguel Garcia Jimenez <segarc21@ucm.es>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License, version 2.0, as
+// published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License, version 2.0, for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+// ---------------------------------------------------------
+// This file is part of DESODBC, an ODBC Driver of the open-source DBMS
+// Datalog Educational System (DES) (see https://des.sourceforge.io/),
+// written by Sergio Miguel Garcia Jimenez <segarc21@ucm.es>, hereinafter
+// the DESODBC developer.
+// ---------------------------------------------------------
+
+/**
+  @file  numparse.cc
+  @brief Batch parsers of the numbers printed by the DES TAPI, which turn
+         a whole column of values into binary at once.
+*/
+
+#include "stringutil.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define NUMPARSE_SIMD 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define NUMPARSE_TARGET(T)
+#else
+#define NUMPARSE_TARGET(T) __attribute__((target(T)))
+#endif
+#endif
+
+/* DESODBC:
+  The batch parsers only take the plain formats the TAPI prints: an
+  optional sign, at most NUMPARSE_MAX_DIGITS digits (a '.' may split them)
+  and, for floats, an optional exponent. Everything else is left to
+  strtoll/myodbc_strtod.
+
+  Original author: DESODBC Developer
+*/
+#define NUMPARSE_MAX_DIGITS 16
+
+namespace {
+
+/* DESODBC:
+  Digits of a value, right-aligned and padded with '0' on the left so
+  that they can be converted as a 16-digit number.
+
+  Original author: DESODBC Developer
+*/
+struct DigitBlock {
+  alignas(16) char digits[NUMPARSE_MAX_DIGITS];
+};
+
+/* DESODBC:
+  A value split into its parts. The value is (negative ? -1 : 1) *
+  significand * 10^exponent, where significand is in block.
+
+  Original author: DESODBC Developer
+*/
+struct NumberParts {
+  DigitBlock block;
+  bool negative;
+  int exponent;
+};
+
+/* DESODBC:
+  This function splits value into its parts, returning false if it does
+  not have the format of a TAPI number. Integers (allow_float false) have
+  neither fraction nor exponent.
+
+  Original author: DESODBC Developer
+*/
+bool split_number(const char *value, unsigned long length, bool allow_float,
+                  NumberParts &parts) {
+  const char *p = value, *end = value + length;
+
+  parts.negative = false;
+  if (p != end && (*p == '-' || *p == '+')) parts.negative = *p++ == '-';
+
+  // Leading zeros do not count
+  const char *digits_start = p;
+  while (p != end && *p == '0') ++p;
+  const char *integer = p;
+  while (p != end && (unsigned char)(*p - '0') < 10) ++p;
+  const char *integer_end = p;
+  bool any_digit = p != digits_start;
+
+  const char *fraction = p, *fraction_end = p;
+  int n_fraction = 0;
+  if (p != end && *p == '.' && allow_float) {
+    const char *point = ++p;
+    // Neither do the zeros after the point of a value below one
+    if (integer == integer_end)
+      while (p != end && *p == '0') ++p;
+    fraction = p;
+    while (p != end && (unsigned char)(*p - '0') < 10) ++p;
+    fraction_end = p;
+    n_fraction = (int)(p - point);
+    any_digit = any_digit || p != point;
+  }
+  if (!any_digit) return false;
+
+  size_t n_integer = integer_end - integer;
+  size_t n_digits = n_integer + (fraction_end - fraction);
+  if (n_digits > NUMPARSE_MAX_DIGITS) return false;
+
+  int exponent = 0;
+  if (p != end && (*p == 'e' || *p == 'E') && allow_float) {
+    ++p;
+    bool negative_exponent = false;
+    if (p != end && (*p == '-' || *p == '+')) negative_exponent = *p++ == '-';
+    if (p == end) return false;
+    for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+      if (exponent > 9999) return false;
+      exponent = exponent * 10 + (*p - '0');
+    }
+    if (negative_exponent) exponent = -exponent;
+  }
+  if (p != end) return false;
+
+  char *digits = parts.block.digits + NUMPARSE_MAX_DIGITS - n_digits;
+  memset(parts.block.digits, '0', NUMPARSE_MAX_DIGITS);
+  memcpy(digits, integer, n_integer);
+  memcpy(digits + n_integer, fraction, fraction_end - fraction);
+  parts.exponent = exponent - n_fraction;
+  return true;
+}
+
+/* DESODBC:
+  Scalar conversion of a block of digits.
+
+  Original author: DESODBC Developer
+*/
+unsigned long long block_value_scalar(const DigitBlock &block) {
+  unsigned long long value = 0;
+  for (int i = 0; i < NUMPARSE_MAX_DIGITS; ++i)
+    value = value * 10 + (block.digits[i] - '0');
+  return value;
+}
+
+#ifdef NUMPARSE_SIMD
+/* DESODBC:
+  SSE4.1 conversion of a block of digits: pairs of digits, then groups of
+  four and of eight are combined with multiply-adds.
+
+  Original author: DESODBC Developer
+*/
+NUMPARSE_TARGET("sse4.1")
+unsigned long long block_value_sse41(const DigitBlock &block) {
+  __m128i chunk = _mm_load_si128((const __m128i *)block.digits);
+  chunk = _mm_sub_epi8(chunk, _mm_set1_epi8('0'));
+
+  const __m128i mul_1_10 =
+      _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1);
+  const __m128i mul_1_100 = _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1);
+  const __m128i mul_1_10000 =
+      _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1);
+
+  __m128i pairs = _mm_maddubs_epi16(chunk, mul_1_10);
+  __m128i quads = _mm_madd_epi16(pairs, mul_1_100);
+  quads = _mm_packus_epi32(quads, quads);
+  __m128i octets = _mm_madd_epi16(quads, mul_1_10000);
+
+  return (unsigned long long)(unsigned int)_mm_cvtsi128_si32(octets) *
+             100000000ULL +
+         (unsigned int)_mm_extract_epi32(octets, 1);
+}
+
+/* DESODBC:
+  AVX2 conversion of two blocks of digits at once, one per 128-bit lane.
+
+  Original author: DESODBC Developer
+*/
+NUMPARSE_TARGET("avx2")
+void block_values_avx2(const DigitBlock &first, const DigitBlock &second,
+                       unsigned long long &first_value,
+                       unsigned long long &second_value) {
+  __m256i chunk = _mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm_load_si128((const __m128i *)first.digits)),
+      _mm_load_si128((const __m128i *)second.digits), 1);
+  chunk = _mm256_sub_epi8(chunk, _mm256_set1_epi8('0'));
+
+  const __m256i mul_1_10 = _mm256_setr_epi8(
+      10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10,
+      1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1);
+  const __m256i mul_1_100 = _mm256_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1,
+                                              100, 1, 100, 1, 100, 1, 100, 1);
+  const __m256i mul_1_10000 =
+      _mm256_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1, 10000, 1,
+                        10000, 1, 10000, 1, 10000, 1);
+
+  __m256i pairs = _mm256_maddubs_epi16(chunk, mul_1_10);
+  __m256i quads = _mm256_madd_epi16(pairs, mul_1_100);
+  quads = _mm256_packus_epi32(quads, quads);
+  __m256i octets = _mm256_madd_epi16(quads, mul_1_10000);
+
+  first_value =
+      (unsigned long long)(unsigned int)_mm256_extract_epi32(octets, 0) *
+          100000000ULL +
+      (unsigned int)_mm256_extract_epi32(octets, 1);
+  second_value =
+      (unsigned long long)(unsigned int)_mm256_extract_epi32(octets, 4) *
+          100000000ULL +
+      (unsigned int)_mm256_extract_epi32(octets, 5);
+}
+#endif
+
+enum BlockKernel { KERNEL_SCALAR, KERNEL_SSE41, KERNEL_AVX2 };
+
+/* DESODBC:
+  The best kernel the processor supports, chosen once.
+
+  Original author: DESODBC Developer
+*/
+BlockKernel block_kernel() {
+  static const BlockKernel kernel = []() {
+#ifdef NUMPARSE_SIMD
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    int max_leaf = info[0];
+    __cpuid(info, 1);
+    bool sse41 = (info[2] & (1 << 19)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0 && (info[2] & (1 << 27)) != 0;
+    bool avx2 = false;
+    if (avx && max_leaf >= 7 && (_xgetbv(0) & 6) == 6) {
+      __cpuidex(info, 7, 0);
+      avx2 = (info[1] & (1 << 5)) != 0;
+    }
+    if (avx2) return KERNEL_AVX2;
+    if (sse41) return KERNEL_SSE41;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return KERNEL_AVX2;
+    if (__builtin_cpu_supports("sse4.1")) return KERNEL_SSE41;
+#endif
+#endif
+    return KERNEL_SCALAR;
+  }();
+  return kernel;
+}
+
+/* DESODBC:
+  This function converts the blocks of digits of count values into
+  significands, with the best kernel available.
+
+  Original author: DESODBC Developer
+*/
+void block_values(const NumberParts *parts, size_t count,
+                  unsigned long long *significands) {
+  size_t i = 0;
+#ifdef NUMPARSE_SIMD
+  switch (block_kernel()) {
+    case KERNEL_AVX2:
+      for (; i + 1 < count; i += 2)
+        block_values_avx2(parts[i].block, parts[i + 1].block,
+                          significands[i], significands[i + 1]);
+      for (; i < count; ++i)
+        significands[i] = block_value_sse41(parts[i].block);
+      return;
+    case KERNEL_SSE41:
+      for (; i < count; ++i)
+        significands[i] = block_value_sse41(parts[i].block);
+      return;
+    default:
+      break;
+  }
+#endif
+  for (; i < count; ++i) significands[i] = block_value_scalar(parts[i].block);
+}
+
+/* DESODBC:
+  Powers of ten that are exact as doubles.
+
+  Original author: DESODBC Developer
+*/
+const double exact_powers_of_ten[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+#define NUMPARSE_BATCH 64
+
+/* DESODBC:
+  This function runs convert over the values in batches of
+  NUMPARSE_BATCH: they are split (skipping NULLs and values of other
+  formats), their digits converted together, and then convert gives the
+  final value of each one. It returns how many values were converted.
+
+  Original author: DESODBC Developer
+*/
+template <typename T, typename Convert>
+size_t parse_batch(const char *const *values, const unsigned long *lengths,
+                   size_t count, bool allow_float, T *out, char *converted,
+                   Convert convert) {
+  NumberParts parts[NUMPARSE_BATCH];
+  size_t index[NUMPARSE_BATCH];
+  unsigned long long significands[NUMPARSE_BATCH];
+  size_t n_converted = 0;
+
+  for (size_t start = 0; start < count; start += NUMPARSE_BATCH) {
+    size_t end = start + NUMPARSE_BATCH < count ? start + NUMPARSE_BATCH
+                                                : count;
+    size_t n = 0;
+    for (size_t i = start; i < end; ++i) {
+      converted[i] = 0;
+      if (values[i] &&
+          split_number(values[i], lengths[i], allow_float, parts[n]))
+        index[n++] = i;
+    }
+
+    block_values(parts, n, significands);
+
+    for (size_t k = 0; k < n; ++k) {
+      if (convert(parts[k], significands[k], out[index[k]])) {
+        converted[index[k]] = 1;
+        ++n_converted;
+      }
+    }
+  }
+  return n_converted;
+}
+
+}  // namespace
+
+/* DESODBC:
+  This function converts a column of integers printed by the TAPI, as
+  strtoll would. values[i] (nullptr for NULL) has lengths[i] characters.
+  converted[i] is set to 1 for every value stored into out[i], and to 0
+  for the ones left to strtoll.
+
+  Original author: DESODBC Developer
+*/
+size_t myodbc_strtoll_batch(const char *const *values,
+                            const unsigned long *lengths, size_t count,
+                            long long *out, char *converted) {
+  return parse_batch(values, lengths, count, false, out, converted,
+                     [](const NumberParts &parts,
+                        unsigned long long significand, long long &value) {
+                       // 16 digits always fit
+                       value = parts.negative ? -(long long)significand
+                                              : (long long)significand;
+                       return true;
+                     });
+}
+
+/* DESODBC:
+  This function converts a column of floats printed by the TAPI, as
+  myodbc_strtod would. Values are only converted when both their
+  significand and the power of ten they are scaled by are exact doubles,
+  since then a single multiplication or division rounds them correctly.
+  converted works as in myodbc_strtoll_batch.
+
+  Original author: DESODBC Developer
+*/
+size_t myodbc_strtod_batch(const char *const *values,
+                           const unsigned long *lengths, size_t count,
+                           double *out, char *converted) {
+  return parse_batch(
+      values, lengths, count, true, out, converted,
+      [](const NumberParts &parts, unsigned long long significand,
+         double &value) {
+        if (significand > (1ULL << 53)) return false;
+
+        double d = (double)significand;
+        if (significand == 0)
+          d = 0.0;
+        else if (parts.exponent >= 0 && parts.exponent <= 22)
+          d *= exact_powers_of_ten[parts.exponent];
+        else if (parts.exponent < 0 && parts.exponent >= -22)
+          d /= exact_powers_of_ten[-parts.exponent];
+        else
+          return false;
+
+        value = parts.negative ? -d : d;
+        return true;
+      });
+}
@@ -139,6 +139,12 @@ bool myodbc_append_os_quoted_std(std::string &str, const char *append, ...);
 unsigned int get_charset_maxlen(unsigned int num);
 void delocalize_radix(char* buffer);
 double myodbc_strtod(const char *str, int len);
+size_t myodbc_strtoll_batch(const char *const *values,
+                            const unsigned long *lengths, size_t count,
+                            long long *out, char *converted);
+size_t myodbc_strtod_batch(const char *const *values,
+                           const unsigned long *lengths, size_t count,
+                           double *out, char *converted);
 
 #ifdef __cplusplus
 }